@@ -0,0 +1,258 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+// Natural merge sort in the spirit of TimSort: the input is cut into its existing ascending and
+// strictly descending runs, short runs are extended with binary insertion sort, and runs are
+// merged through a stack that keeps the run lengths balanced. Sorted input costs one scan.
+
+// Run length below which runs are extended with insertion sort, picked so that n / min_run
+// is a power of two or just below one
+inline size_t adaptive_min_run(size_t size)
+{
+    size_t rest = 0;
+    while (size >= 64)
+    {
+        rest |= size & 1;
+        size >>= 1;
+    }
+    return size + rest;
+}
+
+// Exponential search for the partition point of a range whose prefix satisfies pred,
+// cheap when the point is close to first
+template <typename RandomIt, typename Pred>
+RandomIt gallop_partition_point(RandomIt first, RandomIt last, Pred pred)
+{
+    size_t size = std::distance(first, last);
+    size_t lo = 0;
+    size_t hi = 1;
+    while (hi <= size && pred(*(first + (hi - 1))))
+    {
+        lo = hi;
+        hi = hi * 2 + 1;
+    }
+    return std::partition_point(first + lo, first + std::min(hi, size), pred);
+}
+
+// Finds the run starting at first and makes it ascending, returns its end
+template <typename RandomIt, typename CompFunc>
+RandomIt take_run(RandomIt first, RandomIt last, CompFunc comp, uint64_t & inversions)
+{
+    auto run_end = first + 1;
+    if (run_end == last)
+    {
+        return run_end;
+    }
+
+    if (comp(*run_end, *first))
+    {
+        // Only strictly descending runs are reversed, so equal elements keep their order
+        for (++run_end; run_end != last && comp(*run_end, *(run_end - 1)); ++run_end)
+        {
+        }
+        std::reverse(first, run_end);
+
+        uint64_t length = std::distance(first, run_end);
+        inversions += length * (length - 1) / 2;
+    }
+    else
+    {
+        for (++run_end; run_end != last && !comp(*run_end, *(run_end - 1)); ++run_end)
+        {
+        }
+    }
+
+    return run_end;
+}
+
+// Extends the sorted [first, sorted_end) to [first, last), every shifted element is an inversion
+template <typename RandomIt, typename CompFunc>
+void binary_insertion_sort(RandomIt first, RandomIt sorted_end, RandomIt last, CompFunc comp, uint64_t & inversions)
+{
+    for (; sorted_end != last; ++sorted_end)
+    {
+        auto position = std::upper_bound(first, sorted_end, *sorted_end, comp);
+        inversions += std::distance(position, sorted_end);
+        std::rotate(position, sorted_end, sorted_end + 1);
+    }
+}
+
+// Merges the adjacent sorted [first, middle) and [middle, last) in place, switching to
+// galloping when one side keeps winning
+template <typename RandomIt, typename CompFunc, typename T = std::iter_value_t<RandomIt>>
+uint64_t gallop_merge(RandomIt first, RandomIt middle, RandomIt last, CompFunc comp, std::vector<T> & buffer)
+{
+    constexpr size_t min_gallop = 7;
+
+    // Left elements not greater than the first right one and right elements not less than
+    // the last left one are already in place and take part in no inversion
+    first = std::upper_bound(first, middle, *middle, comp);
+    last = std::lower_bound(middle, last, *(middle - 1), comp);
+    if (first == middle || middle == last)
+    {
+        return 0;
+    }
+
+    buffer.clear();
+    buffer.insert(buffer.end(), std::make_move_iterator(first), std::make_move_iterator(middle));
+
+    uint64_t inversions = 0;
+
+    auto a = buffer.begin();
+    auto a_end = buffer.end();
+    auto b = middle;
+    auto dst = first;
+
+    size_t a_wins = 0;
+    size_t b_wins = 0;
+
+    while (a != a_end && b != last)
+    {
+        if (comp(*b, *a))
+        {
+            inversions += std::distance(a, a_end);
+            *dst++ = std::move(*b++);
+            ++b_wins;
+            a_wins = 0;
+        }
+        else
+        {
+            *dst++ = std::move(*a++);
+            ++a_wins;
+            b_wins = 0;
+        }
+
+        if (a_wins >= min_gallop && a != a_end && b != last)
+        {
+            auto & key = *b;
+            auto a_stop = gallop_partition_point(a, a_end, [&](auto const & x) { return !comp(key, x); });
+            dst = std::move(a, a_stop, dst);
+            a = a_stop;
+            a_wins = 0;
+        }
+
+        if (b_wins >= min_gallop && a != a_end && b != last)
+        {
+            auto & key = *a;
+            auto b_stop = gallop_partition_point(b, last, [&](auto const & x) { return comp(x, key); });
+            inversions += static_cast<uint64_t>(std::distance(b, b_stop)) * std::distance(a, a_end);
+            dst = std::move(b, b_stop, dst);
+            b = b_stop;
+            b_wins = 0;
+        }
+    }
+
+    // Whatever is left of the right run is already in place
+    std::move(a, a_end, dst);
+
+    return inversions;
+}
+
+template <std::random_access_iterator RandomIt, typename CompFunc = std::less<>>
+uint64_t adaptive_merge_sort(RandomIt first, RandomIt last, CompFunc comp = {})
+{
+    using T = std::iter_value_t<RandomIt>;
+
+    struct Run
+    {
+        size_t start;
+        size_t length;
+    };
+
+    size_t size = std::distance(first, last);
+    if (size < 2)
+    {
+        return 0;
+    }
+
+    uint64_t inversions = 0;
+    size_t min_run = adaptive_min_run(size);
+
+    std::vector<Run> runs{};
+    std::vector<T> buffer{};
+
+    auto merge_at = [&](size_t i)
+    {
+        auto & left = runs[i];
+        auto const & right = runs[i + 1];
+
+        auto run_first = first + left.start;
+        inversions += gallop_merge(run_first, run_first + left.length, run_first + (left.length + right.length), comp, buffer);
+
+        left.length += right.length;
+        runs.erase(runs.begin() + (i + 1));
+    };
+
+    for (size_t start = 0; start < size;)
+    {
+        auto run_first = first + start;
+        auto run_last = take_run(run_first, last, comp, inversions);
+
+        size_t length = std::distance(run_first, run_last);
+        if (length < min_run)
+        {
+            size_t extended = std::min(min_run, size - start);
+            binary_insertion_sort(run_first, run_last, run_first + extended, comp, inversions);
+            length = extended;
+        }
+
+        runs.push_back({start, length});
+        start += length;
+
+        // Keep the run lengths growing at least like Fibonacci numbers from the top of the
+        // stack down, checking the three topmost triples so the invariant really holds
+        while (runs.size() > 1)
+        {
+            size_t n = runs.size() - 2;
+            if ((n > 0 && runs[n - 1].length <= runs[n].length + runs[n + 1].length)
+                || (n > 1 && runs[n - 2].length <= runs[n - 1].length + runs[n].length))
+            {
+                if (runs[n - 1].length < runs[n + 1].length)
+                {
+                    --n;
+                }
+                merge_at(n);
+            }
+            else if (runs[n].length <= runs[n + 1].length)
+            {
+                merge_at(n);
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    while (runs.size() > 1)
+    {
+        size_t n = runs.size() - 2;
+        if (n > 0 && runs[n - 1].length < runs[n + 1].length)
+        {
+            --n;
+        }
+        merge_at(n);
+    }
+
+    return inversions;
+}
+
+template <typename T, typename CompFunc>
+std::vector<T> adaptive_merge_sort(std::vector<T> const & data, CompFunc comp, size_t & inversions)
+{
+    std::vector<T> res{data};
+    inversions = adaptive_merge_sort(res.begin(), res.end(), comp);
+    return res;
+}
+
+template <typename T>
+std::vector<T> adaptive_merge_sort(std::vector<T> const & data, size_t & inversions)
+{
+    return adaptive_merge_sort(data, std::less<>{}, inversions);
+}
@@ -0,0 +1,88 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <memory>
+
+namespace
+{
+    thread_local std::pmr::memory_resource * current_resource = nullptr;
+}
+
+std::pmr::memory_resource * temporary_resource()
+{
+    return current_resource ? current_resource : std::pmr::get_default_resource();
+}
+
+Arena::Arena(size_t initial_size, std::pmr::memory_resource * upstream) : Arena({}, initial_size, upstream)
+{
+}
+
+Arena::Arena(std::span<std::byte> buffer, size_t initial_size, std::pmr::memory_resource * upstream)
+    : upstream(upstream), next_size(initial_size), top(buffer.data()), end(buffer.data() + buffer.size())
+{
+}
+
+Arena::~Arena()
+{
+    while (chunk)
+    {
+        Chunk * previous = chunk->previous;
+        upstream->deallocate(chunk, chunk->size, alignof(std::max_align_t));
+        chunk = previous;
+    }
+}
+
+void Arena::add_chunk(size_t size)
+{
+    size = std::max({size, next_size, 4 * sizeof(Chunk)}) + sizeof(Chunk);
+    auto * next = static_cast<Chunk *>(upstream->allocate(size, alignof(std::max_align_t)));
+    *next = Chunk{chunk, size};
+    chunk = next;
+    next_size = 2 * (size - sizeof(Chunk));
+    top = reinterpret_cast<std::byte *>(chunk + 1);
+    end = reinterpret_cast<std::byte *>(chunk) + size;
+}
+
+void * Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    void * p = top;
+    size_t space = static_cast<size_t>(end - top);
+    if (!std::align(alignment, bytes, p, space))
+    {
+        add_chunk(bytes + alignment);
+        p = top;
+        space = static_cast<size_t>(end - top);
+        std::align(alignment, bytes, p, space);
+    }
+
+    top = static_cast<std::byte *>(p) + bytes;
+    return p;
+}
+
+void Arena::do_deallocate(void * p, size_t bytes, size_t)
+{
+    if (static_cast<std::byte *>(p) + bytes == top)
+    {
+        top = static_cast<std::byte *>(p);
+    }
+}
+
+bool Arena::do_is_equal(std::pmr::memory_resource const & other) const noexcept
+{
+    return this == &other;
+}
+
+ArenaScope::ArenaScope(size_t initial_size, std::pmr::memory_resource * upstream) : ArenaScope({}, initial_size, upstream)
+{
+}
+
+ArenaScope::ArenaScope(std::span<std::byte> buffer, size_t initial_size, std::pmr::memory_resource * upstream)
+    : arena{buffer, initial_size, upstream}, previous{current_resource}
+{
+    current_resource = &arena;
+}
+
+ArenaScope::~ArenaScope()
+{
+    current_resource = previous;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+
+// Memory for the temporaries of the limb arithmetic and the transforms. They are taken
+// from the current resource of the thread, the default resource unless an ArenaScope is
+// open on it.
+std::pmr::memory_resource * temporary_resource();
+
+// Bump allocator over chunks taken from an upstream resource, the first one of initial_size
+// bytes when it is needed and each further one at least twice the size of the one before.
+// It can start in a caller's buffer, so operations that fit it never reach upstream.
+// Freeing the most recent allocation moves the top back, so temporaries freed in reverse
+// order of allocation reuse the same memory; anything else is kept until the arena goes away
+// and hands every chunk back in one step. Not thread-safe.
+class Arena : public std::pmr::memory_resource
+{
+public:
+    explicit Arena(size_t initial_size, std::pmr::memory_resource * upstream = std::pmr::get_default_resource());
+    Arena(std::span<std::byte> buffer, size_t initial_size, std::pmr::memory_resource * upstream = std::pmr::get_default_resource());
+    ~Arena() override;
+
+    Arena(Arena const &) = delete;
+    Arena & operator=(Arena const &) = delete;
+
+private:
+    struct Chunk
+    {
+        Chunk * previous;
+        size_t size;
+    };
+
+    void * do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void * p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(std::pmr::memory_resource const & other) const noexcept override;
+
+    void add_chunk(size_t size);
+
+    std::pmr::memory_resource * upstream;
+    size_t next_size;
+    Chunk * chunk = nullptr;
+    std::byte * top = nullptr;
+    std::byte * end = nullptr;
+};
+
+// Makes an Arena the temporary resource of this thread until the scope closes. An
+// operation that sizes initial_size to its working set makes a constant number of upstream
+// calls however many temporaries it creates. Scopes nest; tasks on other threads of a pool
+// keep the resource of their own thread.
+class ArenaScope
+{
+public:
+    explicit ArenaScope(size_t initial_size, std::pmr::memory_resource * upstream = std::pmr::get_default_resource());
+    ArenaScope(std::span<std::byte> buffer, size_t initial_size, std::pmr::memory_resource * upstream = std::pmr::get_default_resource());
+    ~ArenaScope();
+
+    ArenaScope(ArenaScope const &) = delete;
+    ArenaScope & operator=(ArenaScope const &) = delete;
+
+private:
+    Arena arena;
+    std::pmr::memory_resource * previous;
+};
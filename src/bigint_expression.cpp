@@ -0,0 +1,210 @@
+#include "bigint_expression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+#include "digits.hpp"
+
+namespace
+{
+    // A term in the positions of the result, where digit i of the result gets digits[i - first]
+    // for i in [first, last)
+    struct Placed
+    {
+        uint8_t const * digits;
+        size_t first;
+        size_t last;
+        bool negative;
+    };
+
+    // The pass sums the terms 8 digits at a time, in base 10^8
+    constexpr size_t group_digits = 8;
+    constexpr int64_t group_base = 100'000'000;
+    // Groups of the result summed before their carries are taken, 512 digits
+    constexpr size_t block_groups = 64;
+
+    constexpr std::array<int64_t, group_digits + 1> powers_of_ten{1, 10, 100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000, 100'000'000};
+
+    // Digits up to the top of the widest term; a final carry goes in front of them
+    size_t result_width(std::span<ExpressionTerm const> terms)
+    {
+        size_t width = 0;
+        for (auto const & term : terms)
+        {
+            if (!term.source->empty())
+            {
+                width = std::max(width, term.source->size() + term.shift);
+            }
+        }
+        return width;
+    }
+
+    // Value of the digits of a term in [first, last) of the result, a group of it or less
+    int64_t group_value(Placed const & term, size_t first, size_t last)
+    {
+        size_t const from = std::max(first, term.first);
+        size_t const to = std::min(last, term.last);
+        if (from >= to)
+        {
+            return 0;
+        }
+
+        uint8_t const * src = term.digits + (from - term.first);
+        return static_cast<int64_t>(pack_digits(src, to - from) * powers_of_ten[last - to]);
+    }
+
+    // Whether the sum of the terms is negative, found from the top. The digits below a position
+    // add less than one unit at it per term, so the sign is settled as soon as the sum of the
+    // digits above is at least the number of negative terms or at most minus the positive ones.
+    bool negative_sum(std::span<Placed const> placed, size_t width)
+    {
+        int64_t plus = 0;
+        int64_t minus = 0;
+        for (auto const & term : placed)
+        {
+            ++(term.negative ? minus : plus);
+        }
+
+        int64_t prefix = 0;
+        for (size_t first = 0; first < width; first += group_digits)
+        {
+            size_t const last = std::min(first + group_digits, width);
+            prefix *= powers_of_ten[last - first];
+            for (auto const & term : placed)
+            {
+                auto const v = group_value(term, first, last);
+                prefix += term.negative ? -v : v;
+            }
+
+            if (prefix >= minus)
+            {
+                return false;
+            }
+            if (prefix <= -plus)
+            {
+                return true;
+            }
+        }
+        return prefix < 0;
+    }
+
+    // Adds a term to the group sums of the block of the result ending at `last`, group j
+    // ending at last - 8 * j. Only the groups at the ends of the term are partly covered.
+    template <bool Negative>
+    void add_groups(int64_t * sums, size_t first, size_t last, Placed const & term)
+    {
+        size_t const from = std::max(first, term.first);
+        size_t const to = std::min(last, term.last);
+        if (from >= to)
+        {
+            return;
+        }
+
+        size_t const j_first = (last - to) / group_digits;
+        size_t const j_last = (last - from + group_digits - 1) / group_digits;
+        for (size_t j = j_first; j < j_last; ++j)
+        {
+            size_t const group_last = last - j * group_digits;
+            size_t const group_first = group_last - std::min(group_last - first, group_digits);
+            auto const v = group_first >= term.first && group_last <= term.last && group_last - group_first == group_digits
+                               ? static_cast<int64_t>(pack_eight_digits(term.digits + (group_first - term.first)))
+                               : group_value(term, group_first, group_last);
+            sums[j] += Negative ? -v : v;
+        }
+    }
+}
+
+// The result is built in blocks from the least significant end. Each term adds its groups
+// of 8 digits, packed into words, to the sums of a block in a loop of its own; then the
+// carries run through the sums, which are unpacked into the result. Each digit of the
+// result is written once and the carry chain has one division per group.
+void evaluate_terms(bigint & dest, std::span<ExpressionTerm const> terms)
+{
+    for (auto const & term : terms)
+    {
+        if (term.source == &dest)
+        {
+            bigint res{};
+            evaluate_terms(res, terms);
+            dest = std::move(res);
+            return;
+        }
+    }
+
+    size_t const width = result_width(terms);
+
+    SmallVector<Placed, 8> placed{};
+    size_t minus = 0;
+    for (auto const & term : terms)
+    {
+        size_t const size = term.source->size();
+        if (size > 0)
+        {
+            size_t const first = width - term.shift - size;
+            placed.push_back({term.source->data(), first, first + size, term.negative});
+            minus += term.negative;
+        }
+    }
+
+    // dest is left as it was when the result would be negative
+    if (minus > 0 && negative_sum({placed.data(), placed.size()}, width))
+    {
+        throw std::invalid_argument("negative result");
+    }
+
+    // Sums, carry included, stay above -(minus + 1) * 10^8, the bias keeps them non-negative for the division
+    int64_t const bias = static_cast<int64_t>(minus + 1) * group_base;
+
+    dest.clear();
+    dest.reserve(width + 1);
+    dest.resize_for_overwrite(width);
+
+    int64_t carry = 0;
+    int64_t sums[block_groups];
+    for (size_t last = width; last > 0;)
+    {
+        size_t const first = last - std::min(last, block_groups * group_digits);
+        size_t const groups = (last - first + group_digits - 1) / group_digits;
+
+        std::fill(sums, sums + groups, 0);
+        for (auto const & term : placed)
+        {
+            term.negative ? add_groups<true>(sums, first, last, term) : add_groups<false>(sums, first, last, term);
+        }
+
+        for (size_t j = 0; j < groups; ++j)
+        {
+            size_t const group_last = last - j * group_digits;
+            size_t const group_first = group_last - std::min(group_last - first, group_digits);
+            int64_t const sum = sums[j] + carry;
+            if (group_last - group_first == group_digits)
+            {
+                carry = (sum + bias) / group_base - bias / group_base;
+                unpack_eight_digits(static_cast<uint64_t>(sum - carry * group_base), dest.data() + group_first);
+            }
+            else
+            {
+                // The top group of the result is shorter, so is the base of its carry
+                int64_t const base = powers_of_ten[group_last - group_first];
+                carry = sum / base - (sum % base < 0);
+                uint8_t digits[group_digits];
+                unpack_eight_digits(static_cast<uint64_t>(sum - carry * base), digits);
+                std::copy(digits + group_digits - (group_last - group_first), digits + group_digits, dest.data() + group_first);
+            }
+        }
+        last = first;
+    }
+
+    // The carry of many positive terms may take several digits
+    for (; carry > 0; carry /= 10)
+    {
+        dest.insert(dest.begin(), static_cast<uint8_t>(carry % 10));
+    }
+
+    if (!dest.empty() && dest.front() == 0)
+    {
+        dest.erase(dest.begin(), std::find_if(dest.begin(), dest.end(), [](uint8_t d) { return d != 0; }));
+    }
+}
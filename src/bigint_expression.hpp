@@ -0,0 +1,240 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "product.hpp"
+
+// Operators on bigint that build an expression instead of a number. Sums and differences of
+// operands shifted by decimal digits are evaluated in one carry-propagating pass that writes
+// the result straight into its destination, without a number for each intermediate step:
+//
+//     bigint r = (ac << 2 * n) + (ad_plus_bc << n) + bd;
+//
+// Products are computed by multiply and enter the sum as one operand. Only the final result
+// must be non-negative, a difference inside the expression may be negative. Note that << binds
+// more loosely than + and -, so a shifted operand of a sum needs its parentheses.
+//
+// An expression refers to the bigint lvalues it was built from and holds the rvalues, so
+// it can be kept in a variable as long as those lvalues live.
+
+// One operand of the pass, *source times 10^shift
+struct ExpressionTerm
+{
+    bigint const * source;
+    size_t shift;
+    bool negative;
+};
+
+// dest = the signed sum of the terms in one pass from the least significant digit. A term
+// may be dest itself. Throws std::invalid_argument when the sum is negative, before dest is
+// changed.
+void evaluate_terms(bigint & dest, std::span<ExpressionTerm const> terms);
+
+template <typename Derived>
+struct BigintExpression;
+
+template <typename T>
+concept bigint_expression = std::derived_from<std::remove_cvref_t<T>, BigintExpression<std::remove_cvref_t<T>>>;
+
+template <typename T>
+concept bigint_operand = std::same_as<std::remove_cvref_t<T>, bigint> || bigint_expression<T>;
+
+// Terms of an expression and the products computed for them
+template <size_t Terms, size_t Products>
+struct ExpressionTerms
+{
+    std::array<ExpressionTerm, Terms> terms{};
+    std::array<bigint, Products> products{};
+    size_t term_count = 0;
+    size_t product_count = 0;
+
+    void push(bigint const & source, size_t shift, bool negative)
+    {
+        terms[term_count++] = {&source, shift, negative};
+    }
+
+    bigint & next_product() { return products[product_count++]; }
+};
+
+template <bigint_expression E>
+void evaluate(bigint & dest, E const & e);
+
+template <bigint_expression E>
+bigint evaluate(E const & e)
+{
+    bigint res{};
+    evaluate(res, e);
+    return res;
+}
+
+template <typename Derived>
+struct BigintExpression
+{
+    operator bigint() const { return evaluate(static_cast<Derived const &>(*this)); }
+};
+
+// A bigint, referred to for an lvalue and held for an rvalue
+template <typename Storage>
+struct ExpressionOperand : BigintExpression<ExpressionOperand<Storage>>
+{
+    static constexpr size_t terms = 1;
+    static constexpr size_t products = 0;
+
+    Storage value;
+
+    explicit ExpressionOperand(Storage value) : value(std::forward<Storage>(value)) {}
+
+    template <typename Context>
+    void collect(Context & context, size_t shift, bool negative) const
+    {
+        context.push(value, shift, negative);
+    }
+};
+
+template <typename E>
+struct ShiftedExpression : BigintExpression<ShiftedExpression<E>>
+{
+    static constexpr size_t terms = E::terms;
+    static constexpr size_t products = E::products;
+
+    E e;
+    size_t digits;
+
+    ShiftedExpression(E e, size_t digits) : e(std::move(e)), digits(digits) {}
+
+    template <typename Context>
+    void collect(Context & context, size_t shift, bool negative) const
+    {
+        e.collect(context, shift + digits, negative);
+    }
+};
+
+template <typename L, typename R, bool Subtract>
+struct SumExpression : BigintExpression<SumExpression<L, R, Subtract>>
+{
+    static constexpr size_t terms = L::terms + R::terms;
+    static constexpr size_t products = L::products + R::products;
+
+    L lhs;
+    R rhs;
+
+    SumExpression(L lhs, R rhs) : lhs(std::move(lhs)), rhs(std::move(rhs)) {}
+
+    template <typename Context>
+    void collect(Context & context, size_t shift, bool negative) const
+    {
+        lhs.collect(context, shift, negative);
+        rhs.collect(context, shift, negative != Subtract);
+    }
+};
+
+// A bigint operand as it is, any other expression evaluated first
+template <typename E>
+decltype(auto) operand_value(E const & e)
+{
+    if constexpr (requires { e.value; })
+    {
+        return static_cast<bigint const &>(e.value);
+    }
+    else
+    {
+        return evaluate(e);
+    }
+}
+
+template <typename L, typename R>
+struct ProductExpression : BigintExpression<ProductExpression<L, R>>
+{
+    static constexpr size_t terms = 1;
+    static constexpr size_t products = 1;
+
+    L lhs;
+    R rhs;
+
+    ProductExpression(L lhs, R rhs) : lhs(std::move(lhs)), rhs(std::move(rhs)) {}
+
+    // Operands that are one bigint, as in x * x, reach multiply as the same object and are squared
+    bigint value_of() const
+    {
+        decltype(auto) a = operand_value(lhs);
+        decltype(auto) b = operand_value(rhs);
+        return multiply(a, b);
+    }
+
+    template <typename Context>
+    void collect(Context & context, size_t shift, bool negative) const
+    {
+        bigint & product = context.next_product();
+        product = value_of();
+        context.push(product, shift, negative);
+    }
+};
+
+template <bigint_expression E>
+void evaluate(bigint & dest, E const & e)
+{
+    if constexpr (requires { e.value_of(); })
+    {
+        dest = e.value_of();
+    }
+    else
+    {
+        ExpressionTerms<E::terms, E::products> context;
+        e.collect(context, 0, false);
+        evaluate_terms(dest, context.terms);
+    }
+}
+
+template <bigint_operand T>
+auto as_expression(T && x)
+{
+    if constexpr (bigint_expression<T>)
+    {
+        return std::remove_cvref_t<T>(std::forward<T>(x));
+    }
+    else if constexpr (std::is_lvalue_reference_v<T>)
+    {
+        return ExpressionOperand<bigint const &>(x);
+    }
+    else
+    {
+        return ExpressionOperand<bigint>(std::move(x));
+    }
+}
+
+template <bigint_operand L, bigint_operand R>
+auto operator+(L && lhs, R && rhs)
+{
+    auto a = as_expression(std::forward<L>(lhs));
+    auto b = as_expression(std::forward<R>(rhs));
+    return SumExpression<decltype(a), decltype(b), false>(std::move(a), std::move(b));
+}
+
+template <bigint_operand L, bigint_operand R>
+auto operator-(L && lhs, R && rhs)
+{
+    auto a = as_expression(std::forward<L>(lhs));
+    auto b = as_expression(std::forward<R>(rhs));
+    return SumExpression<decltype(a), decltype(b), true>(std::move(a), std::move(b));
+}
+
+template <bigint_operand L, bigint_operand R>
+auto operator*(L && lhs, R && rhs)
+{
+    auto a = as_expression(std::forward<L>(lhs));
+    auto b = as_expression(std::forward<R>(rhs));
+    return ProductExpression<decltype(a), decltype(b)>(std::move(a), std::move(b));
+}
+
+// x times 10^digits
+template <bigint_operand T>
+auto operator<<(T && x, size_t digits)
+{
+    auto e = as_expression(std::forward<T>(x));
+    return ShiftedExpression<decltype(e)>(std::move(e), digits);
+}
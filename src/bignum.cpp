@@ -0,0 +1,376 @@
+#include "bignum.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+
+#include "digits.hpp"
+#include "limbs.hpp"
+
+namespace
+{
+    using limb = BigNum::limb;
+    using wide = unsigned __int128;
+
+    using Arithmetic = Limbs<BinaryBase>;
+    using Decimal = Limbs<DecimalBase>;
+
+    // Largest power of ten that fits into a limb, the unit of the decimal conversions
+    constexpr limb decimal_base = 10'000'000'000'000'000'000ull;
+    constexpr size_t decimal_digits = 19;
+
+    // Conversions of at most this many limbs, or chunks of 19 digits, stay quadratic
+    constexpr size_t conversion_cutoff = 32;
+
+    void normalize(std::vector<limb> & limbs)
+    {
+        while (!limbs.empty() && limbs.back() == 0)
+        {
+            limbs.pop_back();
+        }
+    }
+
+    // Powers base^(2^level) for level = 0, 1, ..., each the square of the one before, kept
+    // between calls. The deque only grows at the end, so handed out references stay valid.
+    template <typename Number>
+    class PowerCache
+    {
+    public:
+        PowerCache(Number base, Number (*square)(Number const &)) : powers{std::move(base)}, square(square) { }
+
+        Number const & operator()(size_t level)
+        {
+            std::lock_guard lock{mutex};
+            while (powers.size() <= level)
+            {
+                powers.push_back(square(powers.back()));
+            }
+            return powers[level];
+        }
+
+    private:
+        std::mutex mutex;
+        std::deque<Number> powers;
+        Number (*square)(Number const &);
+    };
+
+    // Largest level with 2^level < size, for size > 1
+    size_t split_level(size_t size)
+    {
+        return std::bit_width(size - 1) - 1;
+    }
+
+    // Horner's scheme over chunks of 19 decimal digits, most significant first
+    std::vector<limb> limbs_from_digits_basecase(uint8_t const * digits, size_t size)
+    {
+        std::vector<limb> limbs{};
+
+        size_t chunk = size % decimal_digits == 0 ? decimal_digits : size % decimal_digits;
+        for (uint8_t const * last = digits + size; digits != last; digits += chunk, chunk = decimal_digits)
+        {
+            limb value = pack_digits(digits, chunk);
+            limb scale = 1;
+            for (size_t i = 0; i < chunk; ++i)
+            {
+                scale *= 10;
+            }
+
+            limb carry = value;
+            for (auto & x : limbs)
+            {
+                wide product = wide{x} * scale + carry;
+                x = static_cast<limb>(product);
+                carry = static_cast<limb>(product >> 64);
+            }
+            if (carry != 0)
+            {
+                limbs.push_back(carry);
+            }
+        }
+
+        return limbs;
+    }
+
+    // Divide and conquer over 2^level chunks of 19 digits: the low chunks and the rest are
+    // converted on their own and joined as high 10^(19 2^level) + low, so the conversion
+    // costs O(log n) multiplies instead of a quadratic number of limb steps
+    BigNum bignum_from_digits(uint8_t const * digits, size_t size)
+    {
+        static PowerCache<BigNum> ten_powers{BigNum{decimal_base}, square};
+
+        size_t chunks = (size + decimal_digits - 1) / decimal_digits;
+        if (chunks <= conversion_cutoff)
+        {
+            return BigNum{limbs_from_digits_basecase(digits, size)};
+        }
+
+        size_t level = split_level(chunks);
+        size_t low_size = decimal_digits << level;
+
+        auto high = bignum_from_digits(digits, size - low_size);
+        auto low = bignum_from_digits(digits + size - low_size, low_size);
+        return add(multiply(high, ten_powers(level)), low);
+    }
+
+    // Limbs in base 10^9 of a product of two such numbers, without leading zero limbs
+    std::vector<uint32_t> multiply_decimal(std::vector<uint32_t> const & lhs, std::vector<uint32_t> const & rhs)
+    {
+        auto const * as = &lhs;
+        auto const * bs = &rhs;
+        if (as->size() < bs->size())
+        {
+            std::swap(as, bs);
+        }
+
+        if (bs->empty())
+        {
+            return {};
+        }
+
+        std::vector<uint32_t> res(as->size() + bs->size());
+        std::vector<uint32_t> scratch(Decimal::multiply_scratch(as->size(), bs->size()));
+        Decimal::multiply(res.data(), as->data(), as->size(), bs->data(), bs->size(), scratch.data());
+        while (!res.empty() && res.back() == 0)
+        {
+            res.pop_back();
+        }
+        return res;
+    }
+
+    std::vector<uint32_t> square_decimal(std::vector<uint32_t> const & n)
+    {
+        return multiply_decimal(n, n);
+    }
+
+    // Limbs in base 10^9 of x[0, n) by repeated division by 10^18
+    std::vector<uint32_t> decimal_from_limbs_basecase(limb const * x, size_t n)
+    {
+        constexpr limb divisor = 1'000'000'000'000'000'000ull;
+
+        std::vector<limb> limbs(x, x + n);
+        std::vector<uint32_t> res{};
+        normalize(limbs);
+
+        while (!limbs.empty())
+        {
+            limb remainder = 0;
+            for (size_t i = limbs.size(); i > 0; --i)
+            {
+                wide value = (wide{remainder} << 64) | limbs[i - 1];
+                limbs[i - 1] = static_cast<limb>(value / divisor);
+                remainder = static_cast<limb>(value % divisor);
+            }
+            normalize(limbs);
+
+            res.push_back(static_cast<uint32_t>(remainder % DecimalBase::base));
+            res.push_back(static_cast<uint32_t>(remainder / DecimalBase::base));
+        }
+
+        while (!res.empty() && res.back() == 0)
+        {
+            res.pop_back();
+        }
+        return res;
+    }
+
+    // The mirror of bignum_from_digits: the limbs below and above 2^(64 2^level) are converted
+    // on their own and joined with the decimal multiply of the limb code
+    std::vector<uint32_t> decimal_from_limbs(limb const * x, size_t n)
+    {
+        static PowerCache<std::vector<uint32_t>> two_powers{decimal_from_limbs_basecase(std::array<limb, 2>{0, 1}.data(), 2), square_decimal};
+
+        if (n <= conversion_cutoff)
+        {
+            return decimal_from_limbs_basecase(x, n);
+        }
+
+        size_t level = split_level(n);
+        size_t k = size_t{1} << level;
+
+        auto low = decimal_from_limbs(x, k);
+        auto res = multiply_decimal(decimal_from_limbs(x + k, n - k), two_powers(level));
+
+        res.resize(std::max(res.size(), low.size()) + 1, 0);
+        uint32_t carry = Decimal::add(res.data(), res.data(), res.size(), low.data(), low.size());
+        assert(carry == 0);
+        while (!res.empty() && res.back() == 0)
+        {
+            res.pop_back();
+        }
+        return res;
+    }
+
+    // Decimal digits, most significant first, nine to a base 10^9 limb
+    bigint digits_from_limbs(std::vector<limb> const & limbs)
+    {
+        auto decimal = decimal_from_limbs(limbs.data(), limbs.size());
+        bigint digits(decimal.size() * DecimalBase::digits);
+
+        auto digit = digits.rbegin();
+        for (auto x : decimal)
+        {
+            for (size_t i = 0; i < DecimalBase::digits; ++i, ++digit)
+            {
+                *digit = x % 10;
+                x /= 10;
+            }
+        }
+
+        digits.erase(digits.begin(), std::find_if(digits.begin(), digits.end(), [](uint8_t d) { return d != 0; }));
+        return digits;
+    }
+}
+
+BigNum::BigNum(uint64_t value)
+{
+    if (value != 0)
+    {
+        data.push_back(value);
+    }
+}
+
+BigNum::BigNum(std::vector<limb> limbs) : data(std::move(limbs))
+{
+    normalize(data);
+}
+
+BigNum bignum_from_string(std::string const & str)
+{
+    auto digits = bigint_from_string(str);
+    return bignum_from_digits(digits.data(), digits.size());
+}
+
+std::string string_from_bignum(BigNum const & n)
+{
+    return string_from_bigint(digits_from_limbs(n.limbs()));
+}
+
+BigNum bignum_from_bigint(bigint const & n)
+{
+    const bool check = std::all_of(n.cbegin(), n.cend(), [](auto d) { return d <= 9; });
+    if (!check)
+    {
+        throw std::invalid_argument("non-char integer");
+    }
+
+    return bignum_from_digits(n.data(), n.size());
+}
+
+bigint bigint_from_bignum(BigNum const & n)
+{
+    return digits_from_limbs(n.limbs());
+}
+
+std::strong_ordering compare(BigNum const & lhs, BigNum const & rhs)
+{
+    auto const & a = lhs.limbs();
+    auto const & b = rhs.limbs();
+    return Arithmetic::compare(a.data(), a.size(), b.data(), b.size()) <=> 0;
+}
+
+BigNum add(BigNum const & lhs, BigNum const & rhs)
+{
+    auto const * as = &lhs.limbs();
+    auto const * bs = &rhs.limbs();
+    if (as->size() < bs->size())
+    {
+        std::swap(as, bs);
+    }
+
+    std::vector<limb> res(as->size() + 1);
+    res.back() = Arithmetic::add(res.data(), as->data(), as->size(), bs->data(), bs->size());
+    return BigNum{std::move(res)};
+}
+
+BigNum subtract(BigNum const & lhs, BigNum const & rhs)
+{
+    auto const & as = lhs.limbs();
+    auto const & bs = rhs.limbs();
+    assert(as.size() >= bs.size());
+
+    std::vector<limb> res(as.size());
+    limb borrow = Arithmetic::sub(res.data(), as.data(), as.size(), bs.data(), bs.size());
+    assert(borrow == 0);
+    return BigNum{std::move(res)};
+}
+
+BigNum multiply(BigNum const & lhs, BigNum const & rhs)
+{
+    auto const * as = &lhs.limbs();
+    auto const * bs = &rhs.limbs();
+    if (as->size() < bs->size())
+    {
+        std::swap(as, bs);
+    }
+
+    if (bs->empty())
+    {
+        return {};
+    }
+
+    std::vector<limb> res(as->size() + bs->size());
+    std::vector<limb> scratch(Arithmetic::multiply_scratch(as->size(), bs->size()));
+    Arithmetic::multiply(res.data(), as->data(), as->size(), bs->data(), bs->size(), scratch.data());
+    return BigNum{std::move(res)};
+}
+
+// Both operands are the same limbs, which every algorithm of the multiply turns into a square
+BigNum square(BigNum const & n)
+{
+    return multiply(n, n);
+}
+
+std::pair<BigNum, BigNum> divmod(BigNum const & lhs, BigNum const & rhs)
+{
+    auto const & as = lhs.limbs();
+    auto const & bs = rhs.limbs();
+
+    if (bs.empty())
+    {
+        throw std::invalid_argument("division by zero");
+    }
+
+    if (as.size() < bs.size())
+    {
+        return {BigNum{}, lhs};
+    }
+
+    std::vector<limb> quotient(as.size() - bs.size() + 1);
+    std::vector<limb> remainder(bs.size());
+    Arithmetic::divrem(quotient.data(), remainder.data(), as.data(), as.size(), bs.data(), bs.size());
+
+    return {BigNum{std::move(quotient)}, BigNum{std::move(remainder)}};
+}
+
+BigNum multiply(ThreadPool & pool, BigNum const & lhs, BigNum const & rhs)
+{
+    auto const * as = &lhs.limbs();
+    auto const * bs = &rhs.limbs();
+    if (as->size() < bs->size())
+    {
+        std::swap(as, bs);
+    }
+
+    if (bs->empty())
+    {
+        return {};
+    }
+
+    std::vector<limb> res(as->size() + bs->size());
+    Arithmetic::multiply(pool, res.data(), as->data(), as->size(), bs->data(), bs->size());
+    return BigNum{std::move(res)};
+}
+
+MultiplyThresholds & bignum_multiply_thresholds()
+{
+    return Arithmetic::thresholds;
+}
+
+MultiplyThresholds calibrate_bignum_multiply()
+{
+    return Arithmetic::calibrate();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "multiply_thresholds.hpp"
+#include "product.hpp"
+#include "thread_pool.hpp"
+
+// Non-negative integer in base 2^64, least significant limb first, without leading zero
+// limbs; zero has no limbs. Limb products go through 128-bit intermediates.
+class BigNum
+{
+public:
+    using limb = uint64_t;
+
+    BigNum() = default;
+    explicit BigNum(uint64_t value);
+    explicit BigNum(std::vector<limb> limbs);
+
+    std::vector<limb> const & limbs() const { return data; }
+    size_t size() const { return data.size(); }
+    bool is_zero() const { return data.empty(); }
+
+    friend bool operator==(BigNum const &, BigNum const &) = default;
+
+private:
+    std::vector<limb> data{};
+};
+
+BigNum bignum_from_string(std::string const & str);
+
+// Decimal digits without leading zeros. Like string_from_bigint, zero has no digits and
+// gives the empty string.
+std::string string_from_bignum(BigNum const & n);
+
+BigNum bignum_from_bigint(bigint const & n);
+
+bigint bigint_from_bignum(BigNum const & n);
+
+std::strong_ordering compare(BigNum const & lhs, BigNum const & rhs);
+
+inline std::strong_ordering operator<=>(BigNum const & lhs, BigNum const & rhs)
+{
+    return compare(lhs, rhs);
+}
+
+BigNum add(BigNum const & lhs, BigNum const & rhs);
+
+// lhs must not be less than rhs
+BigNum subtract(BigNum const & lhs, BigNum const & rhs);
+
+// Aliased operands, as in multiply(x, x), are squared
+BigNum multiply(BigNum const & lhs, BigNum const & rhs);
+
+BigNum square(BigNum const & n);
+
+// Quotient and remainder, throws std::invalid_argument when rhs is zero
+std::pair<BigNum, BigNum> divmod(BigNum const & lhs, BigNum const & rhs);
+
+// Same product, with the sub-products of large operands run as tasks on the pool
+BigNum multiply(ThreadPool & pool, BigNum const & lhs, BigNum const & rhs);
+
+// Thresholds of the BigNum multiply, in 64-bit limbs. Changing them is not thread-safe.
+MultiplyThresholds & bignum_multiply_thresholds();
+
+MultiplyThresholds calibrate_bignum_multiply();
@@ -0,0 +1,83 @@
+#include "digits.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#    define DIGITS_X86 1
+
+bool digits_from_chars_avx2(char const * chars, size_t size, uint8_t * digits);
+bool chars_from_digits_avx2(uint8_t const * digits, size_t size, char * chars);
+
+bool digits_from_chars_sse42(char const * chars, size_t size, uint8_t * digits);
+bool chars_from_digits_sse42(uint8_t const * digits, size_t size, char * chars);
+#endif
+
+namespace
+{
+    enum class Isa
+    {
+        Scalar,
+        Sse42,
+        Avx2,
+    };
+
+    Isa detect_isa()
+    {
+#if defined(DIGITS_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return Isa::Avx2;
+        }
+        if (__builtin_cpu_supports("sse4.2"))
+        {
+            return Isa::Sse42;
+        }
+#endif
+        return Isa::Scalar;
+    }
+
+    Isa const isa = detect_isa();
+
+    // Same single pass without early exit, left to the compiler to vectorize for the base ISA
+    template <typename In, typename Out>
+    bool convert_scalar(In const * in, size_t size, Out * out, uint8_t from, uint8_t to)
+    {
+        bool good = true;
+        for (size_t i = 0; i < size; ++i)
+        {
+            uint8_t digit = static_cast<uint8_t>(static_cast<uint8_t>(in[i]) - from);
+            good &= digit <= 9;
+            out[i] = static_cast<Out>(static_cast<uint8_t>(digit + to));
+        }
+        return good;
+    }
+}
+
+bool digits_from_chars(char const * chars, size_t size, uint8_t * digits)
+{
+    switch (isa)
+    {
+#if defined(DIGITS_X86)
+        case Isa::Avx2:
+            return digits_from_chars_avx2(chars, size, digits);
+        case Isa::Sse42:
+            return digits_from_chars_sse42(chars, size, digits);
+#endif
+        default:
+            return convert_scalar(chars, size, digits, '0', 0);
+    }
+}
+
+bool chars_from_digits(uint8_t const * digits, size_t size, char * chars)
+{
+    switch (isa)
+    {
+#if defined(DIGITS_X86)
+        case Isa::Avx2:
+            return chars_from_digits_avx2(digits, size, chars);
+        case Isa::Sse42:
+            return chars_from_digits_sse42(digits, size, chars);
+#endif
+        default:
+            return convert_scalar(digits, size, chars, 0, '0');
+    }
+}
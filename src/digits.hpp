@@ -0,0 +1,76 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Conversions between decimal characters and digit values 0..9, one byte each. They check
+// every byte and convert it in the same pass, with AVX2 or SSE4.2 when the CPU has them and
+// a scalar loop otherwise. Both return false if some input byte is out of range, in which
+// case the output is only partly written.
+
+bool digits_from_chars(char const * chars, size_t size, uint8_t * digits);
+
+bool chars_from_digits(uint8_t const * digits, size_t size, char * chars);
+
+// Value of 8 digits, most significant first, combined pairwise inside one 64-bit word
+inline uint64_t pack_eight_digits(uint8_t const * digits)
+{
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        uint64_t v;
+        std::memcpy(&v, digits, sizeof(v));
+        v = v * 10 + (v >> 8);
+        return ((v & 0x000000ff000000ff) * (100 + (uint64_t{1000000} << 32))
+                + ((v >> 16) & 0x000000ff000000ff) * (1 + (uint64_t{10000} << 32)))
+               >> 32;
+    }
+    else
+    {
+        uint64_t v = 0;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            v = v * 10 + digits[i];
+        }
+        return v;
+    }
+}
+
+// Value of at most 19 digits, most significant first
+inline uint64_t pack_digits(uint8_t const * digits, size_t count)
+{
+    uint64_t v = 0;
+    for (; count >= 8; count -= 8, digits += 8)
+    {
+        v = v * 100'000'000 + pack_eight_digits(digits);
+    }
+    for (; count > 0; --count, ++digits)
+    {
+        v = v * 10 + *digits;
+    }
+    return v;
+}
+
+// The 8 digits of value < 10^8, most significant first. The value is split into halves of
+// 4 digits in 32-bit lanes, then pairs in 16-bit lanes, then digits in bytes, dividing by
+// 100 and by 10 through multiplications that stay inside each lane.
+inline void unpack_eight_digits(uint64_t value, uint8_t * digits)
+{
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        uint64_t v = value / 10000 | (value % 10000) << 32;
+        uint64_t hundreds = (v * 10486 >> 20) & 0x0000007f0000007f;
+        v = hundreds | (v - hundreds * 100) << 16;
+        uint64_t tens = (v * 103 >> 10) & 0x000f000f000f000f;
+        v = tens | (v - tens * 10) << 8;
+        std::memcpy(digits, &v, sizeof(v));
+    }
+    else
+    {
+        for (size_t i = 8; i > 0; --i, value /= 10)
+        {
+            digits[i - 1] = static_cast<uint8_t>(value % 10);
+        }
+    }
+}
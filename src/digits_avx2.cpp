@@ -0,0 +1,37 @@
+// Compiled with -mavx2, only called after the CPU has been checked
+
+#include "digits_kernel.hpp"
+
+#if defined(__AVX2__)
+
+#    include <immintrin.h>
+
+namespace
+{
+    struct Avx2Ops
+    {
+        using V = __m256i;
+        static constexpr size_t width = 32;
+
+        static V load(void const * p) { return _mm256_loadu_si256(static_cast<V const *>(p)); }
+        static void store(void * p, V v) { _mm256_storeu_si256(static_cast<V *>(p), v); }
+        static V splat(uint8_t x) { return _mm256_set1_epi8(static_cast<char>(x)); }
+        static V add(V a, V b) { return _mm256_add_epi8(a, b); }
+        static V sub(V a, V b) { return _mm256_sub_epi8(a, b); }
+        static V excess(V v, V limit) { return _mm256_subs_epu8(v, limit); }
+        static V either(V a, V b) { return _mm256_or_si256(a, b); }
+        static bool none(V v) { return _mm256_testz_si256(v, v); }
+    };
+}
+
+bool digits_from_chars_avx2(char const * chars, size_t size, uint8_t * digits)
+{
+    return convert_digits<Avx2Ops>(chars, size, digits, '0', 0);
+}
+
+bool chars_from_digits_avx2(uint8_t const * digits, size_t size, char * chars)
+{
+    return convert_digits<Avx2Ops>(digits, size, chars, 0, '0');
+}
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+// Digit conversion loop shared by the per-ISA translation units. It has internal linkage for
+// the same reason as the merge kernels: each unit compiles its own copy for its instruction set.
+//
+// Ops provides for one vector type V of `width` bytes:
+//   load, store, splat, add, sub (wrapping per byte),
+//   excess(v, limit) (per byte, how far v is above limit, saturating at zero),
+//   either (bitwise or), none (whether every byte is zero).
+
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+
+// out[i] = in[i] - from + to for every byte, returns whether every in[i] - from is a digit.
+// Bytes below `from` wrap around above 9, so one unsigned comparison checks both ends. The
+// bytes past the last whole vector go through the scalar loop.
+template <typename Ops, typename In, typename Out>
+bool convert_digits(In const * in, size_t size, Out * out, uint8_t from, uint8_t to)
+{
+    using V = typename Ops::V;
+
+    V const down = Ops::splat(from);
+    V const up = Ops::splat(to);
+    V const nine = Ops::splat(9);
+    V bad = Ops::splat(0);
+
+    size_t i = 0;
+    for (; i + Ops::width <= size; i += Ops::width)
+    {
+        V digit = Ops::sub(Ops::load(in + i), down);
+        bad = Ops::either(bad, Ops::excess(digit, nine));
+        Ops::store(out + i, Ops::add(digit, up));
+    }
+
+    bool good = Ops::none(bad);
+    for (; i < size; ++i)
+    {
+        uint8_t digit = static_cast<uint8_t>(static_cast<uint8_t>(in[i]) - from);
+        good &= digit <= 9;
+        out[i] = static_cast<Out>(static_cast<uint8_t>(digit + to));
+    }
+
+    return good;
+}
+
+}
@@ -0,0 +1,37 @@
+// Compiled with -msse4.2, only called after the CPU has been checked
+
+#include "digits_kernel.hpp"
+
+#if defined(__SSE4_2__)
+
+#    include <immintrin.h>
+
+namespace
+{
+    struct Sse42Ops
+    {
+        using V = __m128i;
+        static constexpr size_t width = 16;
+
+        static V load(void const * p) { return _mm_loadu_si128(static_cast<V const *>(p)); }
+        static void store(void * p, V v) { _mm_storeu_si128(static_cast<V *>(p), v); }
+        static V splat(uint8_t x) { return _mm_set1_epi8(static_cast<char>(x)); }
+        static V add(V a, V b) { return _mm_add_epi8(a, b); }
+        static V sub(V a, V b) { return _mm_sub_epi8(a, b); }
+        static V excess(V v, V limit) { return _mm_subs_epu8(v, limit); }
+        static V either(V a, V b) { return _mm_or_si128(a, b); }
+        static bool none(V v) { return _mm_testz_si128(v, v); }
+    };
+}
+
+bool digits_from_chars_sse42(char const * chars, size_t size, uint8_t * digits)
+{
+    return convert_digits<Sse42Ops>(chars, size, digits, '0', 0);
+}
+
+bool chars_from_digits_sse42(uint8_t const * digits, size_t size, char * chars)
+{
+    return convert_digits<Sse42Ops>(digits, size, chars, 0, '0');
+}
+
+#endif
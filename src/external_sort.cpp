@@ -0,0 +1,387 @@
+#include "external_sort.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "loser_tree.hpp"
+#include "merge_sort.hpp"
+
+namespace
+{
+    using File = std::unique_ptr<std::FILE, decltype(&std::fclose)>;
+
+    File open_file(std::filesystem::path const & path, char const * mode)
+    {
+        File file{std::fopen(path.c_str(), mode), &std::fclose};
+        if (!file)
+        {
+            throw std::runtime_error("cannot open " + path.string());
+        }
+        return file;
+    }
+
+    // Flushes and closes a file written to. A failure stdio only reports here, such as a full
+    // disk on the last buffered block, is thrown instead of leaving a truncated file behind.
+    void close_file(File & file)
+    {
+        bool failed = std::fflush(file.get()) != 0;
+        failed |= std::fclose(file.release()) != 0;
+        if (failed)
+        {
+            throw std::runtime_error("write error");
+        }
+    }
+
+    // Private directory for the run files, removed with everything in it
+    class TempDirectory
+    {
+    public:
+        explicit TempDirectory(std::string const & base)
+        {
+            std::filesystem::path parent = base.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path{base};
+
+            std::random_device random_device{};
+            std::mt19937_64 mt_19937{(uint64_t{random_device()} << 32) | random_device()};
+
+            do
+            {
+                path = parent / ("external_sort-" + std::to_string(mt_19937()));
+            } while (!std::filesystem::create_directory(path));
+        }
+
+        ~TempDirectory()
+        {
+            std::error_code ignored{};
+            std::filesystem::remove_all(path, ignored);
+        }
+
+        TempDirectory(TempDirectory const &) = delete;
+        TempDirectory & operator=(TempDirectory const &) = delete;
+
+        std::filesystem::path next() { return path / ("run-" + std::to_string(counter++)); }
+
+    private:
+        std::filesystem::path path;
+        size_t counter{0};
+    };
+
+    // Whitespace separated integers read in large blocks
+    class TextReader
+    {
+    public:
+        TextReader(std::filesystem::path const & path, size_t buffer_size) : file(open_file(path, "rb")), buffer(buffer_size) { }
+
+        bool next(int64_t & value)
+        {
+            while (true)
+            {
+                for (; begin != end && is_space(buffer[begin]); ++begin)
+                {
+                }
+
+                // A number is parsed only when it ends inside the buffer
+                size_t token_end = begin;
+                for (; token_end != end && !is_space(buffer[token_end]); ++token_end)
+                {
+                }
+
+                if (begin != end && (token_end != end || eof))
+                {
+                    auto [ptr, ec] = std::from_chars(buffer.data() + begin, buffer.data() + token_end, value);
+                    if (ec != std::errc{} || ptr != buffer.data() + token_end)
+                    {
+                        throw std::invalid_argument("nonint token");
+                    }
+                    begin = token_end;
+                    return true;
+                }
+
+                if (eof)
+                {
+                    return false;
+                }
+
+                refill();
+            }
+        }
+
+    private:
+        static bool is_space(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+        void refill()
+        {
+            std::copy(buffer.begin() + begin, buffer.begin() + end, buffer.begin());
+            end -= begin;
+            begin = 0;
+
+            if (end == buffer.size())
+            {
+                buffer.resize(buffer.size() * 2);
+            }
+
+            size_t read = std::fread(buffer.data() + end, 1, buffer.size() - end, file.get());
+            if (read == 0)
+            {
+                if (std::ferror(file.get()))
+                {
+                    throw std::runtime_error("read error");
+                }
+                eof = true;
+            }
+            end += read;
+        }
+
+        File file;
+        std::vector<char> buffer;
+        size_t begin{0};
+        size_t end{0};
+        bool eof{false};
+    };
+
+    class TextWriter
+    {
+    public:
+        TextWriter(std::filesystem::path const & path, size_t buffer_size) : file(open_file(path, "wb")), buffer(std::max<size_t>(buffer_size, 64))
+        {
+        }
+
+        void write(int64_t value)
+        {
+            if (buffer.size() - used < 32)
+            {
+                flush();
+            }
+            auto [ptr, ec] = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+            *ptr++ = '\n';
+            used = ptr - buffer.data();
+        }
+
+        void flush()
+        {
+            if (std::fwrite(buffer.data(), 1, used, file.get()) != used)
+            {
+                throw std::runtime_error("write error");
+            }
+            used = 0;
+        }
+
+        void close()
+        {
+            flush();
+            close_file(file);
+        }
+
+    private:
+        File file;
+        std::vector<char> buffer;
+        size_t used{0};
+    };
+
+    class RunWriter
+    {
+    public:
+        RunWriter(std::filesystem::path const & path, size_t buffer_size)
+            : file(open_file(path, "wb")), buffer(std::max<size_t>(buffer_size / sizeof(int64_t), 1))
+        {
+        }
+
+        void write(int64_t value)
+        {
+            if (used == buffer.size())
+            {
+                flush();
+            }
+            buffer[used++] = value;
+        }
+
+        void write(int64_t const * values, size_t count)
+        {
+            flush();
+            if (std::fwrite(values, sizeof(int64_t), count, file.get()) != count)
+            {
+                throw std::runtime_error("write error");
+            }
+        }
+
+        void flush()
+        {
+            if (std::fwrite(buffer.data(), sizeof(int64_t), used, file.get()) != used)
+            {
+                throw std::runtime_error("write error");
+            }
+            used = 0;
+        }
+
+        void close()
+        {
+            flush();
+            close_file(file);
+        }
+
+    private:
+        File file;
+        std::vector<int64_t> buffer;
+        size_t used{0};
+    };
+
+    class RunReader
+    {
+    public:
+        RunReader(std::filesystem::path const & path, size_t buffer_size)
+            : file(open_file(path, "rb")), buffer(std::max<size_t>(buffer_size / sizeof(int64_t), 1)), remaining(std::filesystem::file_size(path) / sizeof(int64_t))
+        {
+            refill();
+        }
+
+        bool empty() const { return begin == end; }
+        int64_t front() const { return buffer[begin]; }
+        uint64_t size() const { return remaining + (end - begin); }
+
+        void pop()
+        {
+            if (++begin == end)
+            {
+                refill();
+            }
+        }
+
+    private:
+        void refill()
+        {
+            size_t count = std::min<uint64_t>(buffer.size(), remaining);
+            begin = 0;
+            end = std::fread(buffer.data(), sizeof(int64_t), count, file.get());
+            if (end < count || std::ferror(file.get()))
+            {
+                throw std::runtime_error("read error");
+            }
+            remaining -= end;
+        }
+
+        File file;
+        std::vector<int64_t> buffer;
+        uint64_t remaining;
+        size_t begin{0};
+        size_t end{0};
+    };
+
+    // Merges runs holding consecutive parts of the input, counting the inversions across
+    // them with merge_sources like the in-memory kway_merge
+    template <typename Sink>
+    uint64_t merge_runs(std::vector<std::filesystem::path> const & runs, size_t buffer_size, Sink sink)
+    {
+        std::vector<RunReader> readers{};
+        readers.reserve(runs.size());
+        std::vector<uint64_t> sizes{};
+        sizes.reserve(runs.size());
+
+        for (auto const & run : runs)
+        {
+            readers.emplace_back(run, buffer_size);
+            sizes.push_back(readers.back().size());
+        }
+
+        auto less = [&](size_t i, size_t j)
+        {
+            if (readers[i].empty())
+            {
+                return false;
+            }
+            if (readers[j].empty())
+            {
+                return true;
+            }
+            return readers[i].front() < readers[j].front();
+        };
+
+        return merge_sources<uint64_t>(
+            sizes,
+            less,
+            [&](size_t r)
+            {
+                sink(readers[r].front());
+                readers[r].pop();
+            });
+    }
+}
+
+uint64_t external_sort(std::string const & input_path, std::string const & output_path, ExternalSortOptions const & options)
+{
+    TempDirectory temp{options.temp_directory};
+
+    // merge_sort needs a scratch buffer as large as the chunk
+    size_t chunk_size = std::max<size_t>(options.memory_limit / (2 * sizeof(int64_t)), 1);
+    size_t io_buffer = std::max<size_t>(options.min_run_buffer, sizeof(int64_t));
+
+    uint64_t inversions = 0;
+    std::vector<std::filesystem::path> runs{};
+
+    {
+        TextReader reader{input_path, io_buffer};
+        std::vector<int64_t> chunk{};
+        chunk.reserve(chunk_size);
+
+        auto flush_chunk = [&]()
+        {
+            inversions += merge_sort(chunk.begin(), chunk.end());
+
+            runs.push_back(temp.next());
+            RunWriter writer{runs.back(), 0};
+            writer.write(chunk.data(), chunk.size());
+            writer.close();
+            chunk.clear();
+        };
+
+        int64_t value{};
+        while (reader.next(value))
+        {
+            chunk.push_back(value);
+            if (chunk.size() == chunk_size)
+            {
+                flush_chunk();
+            }
+        }
+
+        if (!chunk.empty() || runs.empty())
+        {
+            flush_chunk();
+        }
+    }
+
+    // Each run being merged plus the output gets one buffer
+    size_t fan_in = std::max<size_t>(options.memory_limit / io_buffer, 3) - 1;
+
+    while (runs.size() > fan_in)
+    {
+        std::vector<std::filesystem::path> merged{};
+        for (size_t first = 0; first < runs.size(); first += fan_in)
+        {
+            std::vector<std::filesystem::path> group{runs.begin() + first, runs.begin() + std::min(first + fan_in, runs.size())};
+
+            merged.push_back(temp.next());
+            RunWriter writer{merged.back(), io_buffer};
+            inversions += merge_runs(group, io_buffer, [&](int64_t value) { writer.write(value); });
+            writer.close();
+
+            for (auto const & run : group)
+            {
+                std::filesystem::remove(run);
+            }
+        }
+        runs = std::move(merged);
+    }
+
+    size_t buffer_size = std::max(options.memory_limit / (runs.size() + 1), io_buffer);
+
+    TextWriter writer{output_path, buffer_size};
+    inversions += merge_runs(runs, buffer_size, [&](int64_t value) { writer.write(value); });
+    writer.close();
+
+    return inversions;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct ExternalSortOptions
+{
+    // Bytes used for the in-memory chunks and for the read buffers of the merge phase
+    size_t memory_limit{size_t{256} << 20};
+
+    // Every run being merged gets at least this much of the memory as its read buffer,
+    // runs that do not fit are merged in several rounds
+    size_t min_run_buffer{size_t{64} << 10};
+
+    // Temporary run files go to a private directory created under this one,
+    // empty means the system temporary directory
+    std::string temp_directory{};
+};
+
+// Sorts a text file of whitespace separated integers that does not have to fit in memory
+// and writes them to output_path, one per line. RAM-sized chunks are sorted with merge_sort
+// into binary run files which are then merged k ways. Returns the number of inversions
+// of the whole input, the ones across runs included.
+uint64_t external_sort(std::string const & input_path, std::string const & output_path, ExternalSortOptions const & options = {});
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Binary indexed tree: point updates and prefix sums in O(log n)
+template <typename T>
+class Fenwick
+{
+public:
+    explicit Fenwick(size_t size) : tree(size + 1, T{}) { }
+
+    size_t size() const { return tree.size() - 1; }
+
+    void add(size_t index, T delta)
+    {
+        for (++index; index < tree.size(); index += index & (~index + 1))
+        {
+            tree[index] += delta;
+        }
+    }
+
+    // Sum of the first `count` elements
+    T prefix(size_t count) const
+    {
+        T sum{};
+        for (; count > 0; count -= count & (~count + 1))
+        {
+            sum += tree[count];
+        }
+        return sum;
+    }
+
+private:
+    std::vector<T> tree;
+};
@@ -0,0 +1,67 @@
+#include "interleaved.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#include "interleaved_kernel.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#    define INTERLEAVED_X86 1
+
+void multiply_interleaved_avx2(uint64_t const * a, size_t an, uint64_t const * b, size_t bn, uint64_t * r);
+#endif
+
+namespace
+{
+    InterleavedKernel detect_kernel()
+    {
+#if defined(INTERLEAVED_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return InterleavedKernel::Avx2;
+        }
+#endif
+        return InterleavedKernel::Scalar;
+    }
+
+    InterleavedKernel const best_kernel = detect_kernel();
+    InterleavedKernel current_kernel = best_kernel;
+
+    struct ScalarOps
+    {
+        using V = uint64_t;
+        static constexpr size_t width = 1;
+
+        static V load(uint64_t const * p) { return *p; }
+        static void store(uint64_t * p, V v) { *p = v; }
+        static V add(V a, V b) { return a + b; }
+        static V mul(V a, V b) { return (a & 0xffffffff) * (b & 0xffffffff); }
+    };
+}
+
+void multiply_interleaved(uint64_t const * a, size_t an, uint64_t const * b, size_t bn, uint64_t * r)
+{
+#if defined(INTERLEAVED_X86)
+    if (current_kernel == InterleavedKernel::Avx2)
+    {
+        multiply_interleaved_avx2(a, an, b, bn, r);
+        return;
+    }
+#endif
+    multiply_interleaved_kernel<ScalarOps>(a, an, b, bn, r);
+}
+
+bool interleaved_supports(InterleavedKernel kernel)
+{
+    return kernel <= best_kernel;
+}
+
+InterleavedKernel use_interleaved_kernel(InterleavedKernel kernel)
+{
+    if (!interleaved_supports(kernel))
+    {
+        throw std::invalid_argument("kernel not supported");
+    }
+    return std::exchange(current_kernel, kernel);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Schoolbook products of base 10^9 numbers taken interleaved_lanes at a time. The limbs of
+// the lanes are interleaved, x[i * interleaved_lanes + l] being limb i of lane l, so that
+// one vector instruction multiplies the same limb of several products. Limbs are held in
+// 64-bit words, with AVX2 when the CPU has it and a scalar loop otherwise.
+constexpr size_t interleaved_lanes = 8;
+
+// r[0, (an + bn) * interleaved_lanes) = a_l * b_l for every lane l, in the same layout.
+// Column sums stay in 64 bits and are carried every 16 rows, below the 18 products of
+// limbs under 10^9 that a word can hold.
+void multiply_interleaved(uint64_t const * a, size_t an, uint64_t const * b, size_t bn, uint64_t * r);
+
+// Kernels of multiply_interleaved
+enum class InterleavedKernel
+{
+    Scalar,
+    Avx2,
+};
+
+// Whether this CPU can run the kernel
+bool interleaved_supports(InterleavedKernel kernel);
+
+// Makes multiply_interleaved run the given kernel and returns the one it ran before, throws
+// std::invalid_argument if the CPU does not support it. It is meant for tests that check
+// every kernel; changing it is not thread-safe.
+InterleavedKernel use_interleaved_kernel(InterleavedKernel kernel);
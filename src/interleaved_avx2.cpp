@@ -0,0 +1,28 @@
+// Compiled with -mavx2, only called after the CPU has been checked
+
+#include "interleaved_kernel.hpp"
+
+#if defined(__AVX2__)
+
+#    include <immintrin.h>
+
+namespace
+{
+    struct Avx2Ops
+    {
+        using V = __m256i;
+        static constexpr size_t width = 4;
+
+        static V load(uint64_t const * p) { return _mm256_loadu_si256(reinterpret_cast<V const *>(p)); }
+        static void store(uint64_t * p, V v) { _mm256_storeu_si256(reinterpret_cast<V *>(p), v); }
+        static V add(V a, V b) { return _mm256_add_epi64(a, b); }
+        static V mul(V a, V b) { return _mm256_mul_epu32(a, b); }
+    };
+}
+
+void multiply_interleaved_avx2(uint64_t const * a, size_t an, uint64_t const * b, size_t bn, uint64_t * r)
+{
+    multiply_interleaved_kernel<Avx2Ops>(a, an, b, bn, r);
+}
+
+#endif
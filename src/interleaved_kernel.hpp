@@ -0,0 +1,68 @@
+#pragma once
+
+// Interleaved product loop shared by the per-ISA translation units. It has internal linkage
+// for the same reason as the merge kernels: each unit compiles its own copy for its
+// instruction set.
+//
+// Ops provides for one vector type V of `width` 64-bit words:
+//   load, store, add (per word), mul (low 32 bits of each word into a 64-bit product).
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "interleaved.hpp"
+
+namespace
+{
+
+template <typename Ops>
+void multiply_interleaved_kernel(uint64_t const * a, size_t an, uint64_t const * b, size_t bn, uint64_t * r)
+{
+    using V = typename Ops::V;
+    constexpr size_t lanes = interleaved_lanes;
+    constexpr size_t vectors = lanes / Ops::width;
+    static_assert(lanes % Ops::width == 0);
+
+    constexpr uint64_t base = 1'000'000'000;
+    constexpr size_t rows_per_carry = 16;
+
+    size_t rn = an + bn;
+    std::fill(r, r + rn * lanes, uint64_t{0});
+
+    for (size_t first = 0; first < an; first += rows_per_carry)
+    {
+        size_t last = std::min(an, first + rows_per_carry);
+        for (size_t i = first; i < last; ++i)
+        {
+            V x[vectors];
+            for (size_t v = 0; v < vectors; ++v)
+            {
+                x[v] = Ops::load(a + i * lanes + v * Ops::width);
+            }
+
+            for (size_t j = 0; j < bn; ++j)
+            {
+                uint64_t * column = r + (i + j) * lanes;
+                uint64_t const * y = b + j * lanes;
+                for (size_t v = 0; v < vectors; ++v)
+                {
+                    V product = Ops::mul(x[v], Ops::load(y + v * Ops::width));
+                    Ops::store(column + v * Ops::width, Ops::add(Ops::load(column + v * Ops::width), product));
+                }
+            }
+        }
+
+        // The columns below `first` are already carried and got nothing from these rows
+        for (size_t k = first; k + 1 < rn; ++k)
+        {
+            for (size_t l = 0; l < lanes; ++l)
+            {
+                r[(k + 1) * lanes + l] += r[k * lanes + l] / base;
+                r[k * lanes + l] %= base;
+            }
+        }
+    }
+}
+
+}
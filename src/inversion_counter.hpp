@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+
+// Inversion count of a window over a stream, kept up to date in O(log n) per event. The keys
+// of an unbounded feed are not known up front, so instead of a Fenwick tree over compressed
+// keys the window lives in an order statistics tree; equal keys are told apart by their
+// arrival number, which keeps the count identical to merge_sort's on the same window.
+template <typename T, typename CompFunc = std::less<>>
+class InversionCounter
+{
+public:
+    // A non-zero window_size drops the oldest element whenever a push makes the window larger
+    explicit InversionCounter(size_t window_size = 0, CompFunc comp = {})
+        : window_size(window_size), tree(Less{std::move(comp)})
+    {
+    }
+
+    size_t size() const { return window.size(); }
+    bool empty() const { return window.empty(); }
+
+    // Inversions among the elements currently in the window
+    uint64_t inversions() const { return count; }
+
+    T const & oldest() const { return window.front().first; }
+
+    void push(T value)
+    {
+        Entry entry{std::move(value), arrivals++};
+
+        // Every element already in the window that is greater than the new one
+        count += tree.size() - tree.order_of_key(entry);
+
+        tree.insert(entry);
+        window.push_back(std::move(entry));
+
+        if (window_size != 0 && window.size() > window_size)
+        {
+            pop();
+        }
+    }
+
+    void pop()
+    {
+        auto const & entry = window.front();
+
+        // Every element after the oldest one that is less than it
+        count -= tree.order_of_key(entry);
+
+        tree.erase(entry);
+        window.pop_front();
+    }
+
+private:
+    using Entry = std::pair<T, uint64_t>;
+
+    struct Less
+    {
+        CompFunc comp;
+
+        bool operator()(Entry const & a, Entry const & b) const
+        {
+            if (comp(a.first, b.first))
+            {
+                return true;
+            }
+            if (comp(b.first, a.first))
+            {
+                return false;
+            }
+            return a.second < b.second;
+        }
+    };
+
+    using Tree = __gnu_pbds::tree<Entry, __gnu_pbds::null_type, Less, __gnu_pbds::rb_tree_tag, __gnu_pbds::tree_order_statistics_node_update>;
+
+    size_t window_size;
+    Tree tree;
+    std::deque<Entry> window{};
+    uint64_t arrivals{0};
+    uint64_t count{0};
+};
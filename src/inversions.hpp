@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "merge_sort.hpp"
+#include "thread_pool.hpp"
+
+// 128-bit accumulator for inputs where n^2 / 2 may not fit into 64 bits
+using WideCounter = unsigned __int128;
+
+// Count-only inversion engine: sorts a private copy of the keys, but the last pass,
+// which would write the whole sorted sequence, only counts across the two halves.
+
+template <typename Counter = uint64_t, typename T, typename CompFunc>
+Counter count_inversions(std::vector<T> const & data, CompFunc comp)
+{
+    size_t size = data.size();
+    if (size < 2)
+    {
+        return 0;
+    }
+
+    std::vector<T> buf1{data};
+    std::vector<T> buf2(size);
+
+    auto * src = &buf1;
+    auto * dst = &buf2;
+
+    Counter inversions = 0;
+
+    size_t split = 1;
+    for (; split * 2 < size; split *= 2)
+    {
+        size_t step = split * 2;
+        for (size_t first = 0; first < size; first += step)
+        {
+            size_t middle = std::min(first + split, size);
+            size_t last = std::min(first + step, size);
+            inversions += ::merge<Counter>(dst->begin() + first, src->begin() + first, src->begin() + middle, src->begin() + last, comp);
+        }
+        std::swap(src, dst);
+    }
+
+    inversions += count_merge_inversions<Counter>(src->begin(), src->begin() + split, src->begin() + split, src->end(), comp);
+
+    return inversions;
+}
+
+template <typename Counter = uint64_t, typename T>
+Counter count_inversions(std::vector<T> const & data)
+{
+    return count_inversions<Counter>(data, [](T const & a, T const & b) { return a < b; });
+}
+
+// Every pass is spread over the pool, each task keeps its own partial count and the
+// partial counts are added up once the pass is done
+template <typename Counter = uint64_t, typename T, typename CompFunc>
+Counter count_inversions(ThreadPool & pool, std::vector<T> const & data, CompFunc comp)
+{
+    size_t size = data.size();
+    if (size < 2)
+    {
+        return 0;
+    }
+
+    std::vector<T> buf1{data};
+    std::vector<T> buf2(size);
+
+    auto * src = &buf1;
+    auto * dst = &buf2;
+
+    Counter inversions = 0;
+
+    size_t split = 1;
+    for (; split * 2 < size; split *= 2)
+    {
+        inversions += parallel_merge_pass<Counter>(pool, src->begin(), dst->begin(), size, split, comp, false);
+        std::swap(src, dst);
+    }
+
+    inversions += parallel_merge_pass<Counter>(pool, src->begin(), dst->begin(), size, split, comp, true);
+
+    return inversions;
+}
+
+template <typename Counter = uint64_t, typename T>
+Counter count_inversions(ThreadPool & pool, std::vector<T> const & data)
+{
+    return count_inversions<Counter>(pool, data, [](T const & a, T const & b) { return a < b; });
+}
@@ -0,0 +1,1118 @@
+#pragma once
+
+// Arithmetic on little-endian limb arrays in a fixed base, shared by the binary BigNum and
+// the decimal digit multiply. Everything works on raw spans: results go to caller-provided
+// memory and the products take one scratch area sized up front, so nothing allocates below
+// the transform sizes. The temporaries of the transforms, the pool and the division come
+// from temporary_resource().
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <memory_resource>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "arena.hpp"
+#include "multiply_thresholds.hpp"
+#include "ntt.hpp"
+#include "thread_pool.hpp"
+
+// Base 2^64, products through 128-bit intermediates
+struct BinaryBase
+{
+    using limb = uint64_t;
+    using wide = unsigned __int128;
+    static constexpr wide base = wide{1} << 64;
+
+    static constexpr MultiplyThresholds default_thresholds{24, 768, 1024, 16384, 2048};
+    static constexpr size_t default_newton_threshold = 1024;
+
+    // The transform takes every limb as two 32-bit digits
+    static constexpr size_t ntt_pieces = 2;
+    static constexpr uint64_t ntt_piece_base = uint64_t{1} << 32;
+};
+
+// Base 10^9, so that decimal digits convert in linear time and products fit in 64 bits
+struct DecimalBase
+{
+    using limb = uint32_t;
+    using wide = uint64_t;
+    static constexpr wide base = 1'000'000'000;
+    static constexpr size_t digits = 9;
+
+    static constexpr MultiplyThresholds default_thresholds{24, 768, 1024, 2560, 4096};
+    static constexpr size_t default_newton_threshold = 192;
+
+    static constexpr size_t ntt_pieces = 1;
+    static constexpr uint64_t ntt_piece_base = base;
+};
+
+template <typename Base>
+struct Limbs
+{
+    using limb = typename Base::limb;
+    using wide = typename Base::wide;
+    static constexpr wide base = Base::base;
+
+    using buffer = std::pmr::vector<limb>;
+
+    // r = a + b over n limbs, returns the carry out
+    static limb add_n(limb * r, limb const * a, limb const * b, size_t n)
+    {
+        limb carry = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            wide sum = wide{a[i]} + b[i] + carry;
+            carry = sum >= base;
+            r[i] = static_cast<limb>(sum - (carry ? base : 0));
+        }
+        return carry;
+    }
+
+    // r = a + carry over n limbs, returns the carry out
+    static limb add_1(limb * r, limb const * a, size_t n, limb carry)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            wide sum = wide{a[i]} + carry;
+            carry = sum >= base;
+            r[i] = static_cast<limb>(sum - (carry ? base : 0));
+        }
+        return carry;
+    }
+
+    // r = a - b over n limbs, returns the borrow out
+    static limb sub_n(limb * r, limb const * a, limb const * b, size_t n)
+    {
+        limb borrow = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            wide subtrahend = wide{b[i]} + borrow;
+            borrow = a[i] < subtrahend;
+            r[i] = static_cast<limb>(a[i] + (borrow ? base : 0) - subtrahend);
+        }
+        return borrow;
+    }
+
+    static limb sub_1(limb * r, limb const * a, size_t n, limb borrow)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            wide subtrahend = borrow;
+            borrow = a[i] < subtrahend;
+            r[i] = static_cast<limb>(a[i] + (borrow ? base : 0) - subtrahend);
+        }
+        return borrow;
+    }
+
+    // r = a + b with an >= bn, returns the carry out of the an limbs
+    static limb add(limb * r, limb const * a, size_t an, limb const * b, size_t bn)
+    {
+        limb carry = add_n(r, a, b, bn);
+        return add_1(r + bn, a + bn, an - bn, carry);
+    }
+
+    // r = a - b with an >= bn, returns the borrow out of the an limbs
+    static limb sub(limb * r, limb const * a, size_t an, limb const * b, size_t bn)
+    {
+        limb borrow = sub_n(r, a, b, bn);
+        return sub_1(r + bn, a + bn, an - bn, borrow);
+    }
+
+    // Sign of a - b, zero limbs above the shorter operand do not matter
+    static int compare(limb const * a, size_t an, limb const * b, size_t bn)
+    {
+        for (; an > bn; --an)
+        {
+            if (a[an - 1] != 0)
+            {
+                return 1;
+            }
+        }
+        for (; bn > an; --bn)
+        {
+            if (b[bn - 1] != 0)
+            {
+                return -1;
+            }
+        }
+        for (size_t i = an; i > 0; --i)
+        {
+            if (a[i - 1] != b[i - 1])
+            {
+                return a[i - 1] < b[i - 1] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    // r = |a - b| over an limbs with an >= bn, returns whether a < b
+    static bool sub_abs(limb * r, limb const * a, size_t an, limb const * b, size_t bn)
+    {
+        if (compare(a, an, b, bn) >= 0)
+        {
+            sub(r, a, an, b, bn);
+            return false;
+        }
+
+        // a < b means the limbs of a above bn are all zero
+        sub_n(r, b, a, bn);
+        std::fill(r + bn, r + an, limb{0});
+        return true;
+    }
+
+    // r += a * b over n limbs, returns the limb carried out
+    static limb addmul_1(limb * r, limb const * a, size_t n, limb b)
+    {
+        limb carry = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            wide product = wide{a[i]} * b + r[i] + carry;
+            r[i] = static_cast<limb>(product % base);
+            carry = static_cast<limb>(product / base);
+        }
+        return carry;
+    }
+
+    // r[0, an + bn) = a * b
+    static void mul_basecase(limb * r, limb const * a, size_t an, limb const * b, size_t bn)
+    {
+        std::fill(r, r + an, limb{0});
+        for (size_t j = 0; j < bn; ++j)
+        {
+            r[an + j] = addmul_1(r + j, a, an, b[j]);
+        }
+    }
+
+    // r[0, 2n) = a^2: every cross product a_i a_j with i < j is formed once and doubled,
+    // then the squares of the limbs are added on the diagonal
+    static void sqr_basecase(limb * r, limb const * a, size_t n)
+    {
+        std::fill(r, r + 2 * n, limb{0});
+        for (size_t i = 0; i + 1 < n; ++i)
+        {
+            r[i + n] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+        }
+
+        limb carry = add_n(r, r, r, 2 * n);
+        assert(carry == 0);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            wide square = wide{a[i]} * a[i];
+            wide low = wide{r[2 * i]} + static_cast<limb>(square % base) + carry;
+            wide high = wide{r[2 * i + 1]} + static_cast<limb>(square / base) + static_cast<limb>(low / base);
+            r[2 * i] = static_cast<limb>(low % base);
+            r[2 * i + 1] = static_cast<limb>(high % base);
+            carry = static_cast<limb>(high / base);
+        }
+        assert(carry == 0);
+    }
+
+    // Schoolbook product, or the square kernel when both operands are the same limbs
+    static void basecase(limb * r, limb const * a, size_t an, limb const * b, size_t bn)
+    {
+        if (a == b && an == bn)
+        {
+            sqr_basecase(r, a, an);
+        }
+        else
+        {
+            mul_basecase(r, a, an, b, bn);
+        }
+    }
+
+    // Products of operands at least this many limbs long use the algorithm, the largest
+    // applicable one wins. SIZE_MAX turns an algorithm off.
+    static inline MultiplyThresholds thresholds = Base::default_thresholds;
+
+    static bool use_ntt(size_t an, size_t bn)
+    {
+        return bn >= thresholds.ntt && ntt_fits(an * Base::ntt_pieces, bn * Base::ntt_pieces, Base::ntt_piece_base);
+    }
+
+    // r[0, an + bn) = a * b through ntt_multiply on the limbs cut into transform digits. A
+    // square is cut once and passed as both operands, which ntt_multiply transforms once.
+    static void multiply_ntt(limb * r, limb const * a, size_t an, limb const * b, size_t bn)
+    {
+        constexpr size_t pieces = Base::ntt_pieces;
+        constexpr wide piece_base = Base::ntt_piece_base;
+
+        auto split = [](limb const * x, size_t n)
+        {
+            std::pmr::vector<uint32_t> res(n * pieces, temporary_resource());
+            for (size_t i = 0; i < n; ++i)
+            {
+                wide value = x[i];
+                for (size_t j = 0; j < pieces; ++j, value /= piece_base)
+                {
+                    res[i * pieces + j] = static_cast<uint32_t>(value % piece_base);
+                }
+            }
+            return res;
+        };
+
+        auto as = split(a, an);
+        auto bs = a == b && an == bn ? std::pmr::vector<uint32_t>{temporary_resource()} : split(b, bn);
+        uint32_t const * b_pieces = bs.empty() ? as.data() : bs.data();
+        std::pmr::vector<uint32_t> product((an + bn) * pieces, temporary_resource());
+        ntt_multiply(as.data(), an * pieces, b_pieces, bn * pieces, Base::ntt_piece_base, product.data());
+
+        for (size_t i = 0; i < an + bn; ++i)
+        {
+            wide value = 0;
+            for (size_t j = pieces; j > 0; --j)
+            {
+                value = value * piece_base + product[i * pieces + j - 1];
+            }
+            r[i] = static_cast<limb>(value);
+        }
+    }
+
+    static size_t karatsuba_scratch(size_t n)
+    {
+        if (n < thresholds.karatsuba || use_ntt(n, n))
+        {
+            return 0;
+        }
+        return karatsuba_step_scratch(n);
+    }
+
+    static size_t karatsuba_step_scratch(size_t n)
+    {
+        size_t h = n - n / 2;
+        return 2 * h + 1 + karatsuba_scratch(h);
+    }
+
+    static void karatsuba(limb * r, limb const * a, limb const * b, size_t n, limb * scratch)
+    {
+        if (n < thresholds.karatsuba)
+        {
+            basecase(r, a, n, b, n);
+        }
+        else if (use_ntt(n, n))
+        {
+            multiply_ntt(r, a, n, b, n);
+        }
+        else
+        {
+            karatsuba_step(r, a, b, n, scratch);
+        }
+    }
+
+    // r[0, 2n) = a * b for two n-limb operands, r must not overlap them. With a = a0 + a1 B^h
+    // and b = b0 + b1 B^h the middle term is a0 b0 + a1 b1 - (a0 - a1)(b0 - b1), which needs
+    // no carry limbs. |a0 - a1| and |b0 - b1| live in r until their product is done, the
+    // scratch holds that product and then the middle term, about 2n limbs over all levels.
+    // When a and b are the same limbs all three products are squares.
+    static void karatsuba_step(limb * r, limb const * a, limb const * b, size_t n, limb * scratch)
+    {
+        size_t h = n - n / 2;
+        size_t m = n / 2;
+
+        limb * t = scratch;
+        limb * rest = scratch + 2 * h + 1;
+
+        auto [da, db, negative] = karatsuba_differences(r, r + h, a, b, n);
+        karatsuba(t, da, db, h, rest);
+
+        karatsuba(r, a, b, h, rest);
+        karatsuba(r + 2 * h, a + h, b + h, m, rest);
+
+        karatsuba_middle(r, t, n, negative);
+    }
+
+    // |a0 - a1| to da and |b0 - b1| to db with the sign of their product. For a square db is
+    // left alone and da returned twice, so that the product of the differences is a square too.
+    static std::tuple<limb *, limb *, bool> karatsuba_differences(limb * da, limb * db, limb const * a, limb const * b, size_t n)
+    {
+        size_t h = n - n / 2;
+        size_t m = n / 2;
+
+        bool a_negative = sub_abs(da, a, h, a + h, m);
+        if (a == b)
+        {
+            return {da, da, false};
+        }
+        return {da, db, a_negative != sub_abs(db, b, h, b + h, m)};
+    }
+
+    // Given r = a0 b0 + a1 b1 B^2h and t = (a0 - a1)(b0 - b1) in 2h limbs with its sign,
+    // adds the middle term to r; t needs 2h + 1 limbs
+    static void karatsuba_middle(limb * r, limb * t, size_t n, bool negative)
+    {
+        size_t h = n - n / 2;
+        size_t m = n / 2;
+
+        // t = a0 b0 -+ t + a1 b1, a borrow out of the first step is always paid back by the
+        // carries of the second as the middle term is never negative
+        limb carry = 0;
+        limb borrow = 0;
+        if (negative)
+        {
+            carry = add_n(t, t, r, 2 * h);
+        }
+        else
+        {
+            borrow = sub_n(t, r, t, 2 * h);
+        }
+        carry += add(t, t, 2 * h, r + 2 * h, 2 * m);
+        t[2 * h] = carry - borrow;
+
+        carry = add(r + h, r + h, 2 * n - h, t, 2 * h + 1);
+        assert(carry == 0);
+    }
+
+    // r = a * x for a small x, returns the limb carried out
+    static limb mul_1(limb * r, limb const * a, size_t n, limb x)
+    {
+        limb carry = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            wide product = wide{a[i]} * x + carry;
+            r[i] = static_cast<limb>(product % base);
+            carry = static_cast<limb>(product / base);
+        }
+        return carry;
+    }
+
+    // r = a / X for a small X dividing a. A binary limb is divided in two 32-bit halves so
+    // that every step is a 64-bit division by a constant.
+    template <limb X>
+    static void divexact_1(limb * r, limb const * a, size_t n)
+    {
+        uint64_t remainder = 0;
+        for (size_t i = n; i > 0; --i)
+        {
+            if constexpr (sizeof(limb) == sizeof(uint64_t))
+            {
+                uint64_t high = (remainder << 32) | (a[i - 1] >> 32);
+                remainder = high % X;
+                uint64_t low = (remainder << 32) | (a[i - 1] & 0xffffffff);
+                remainder = low % X;
+                r[i - 1] = ((high / X) << 32) | (low / X);
+            }
+            else
+            {
+                uint64_t value = remainder * base + a[i - 1];
+                r[i - 1] = static_cast<limb>(value / X);
+                remainder = value % X;
+            }
+        }
+        assert(remainder == 0);
+    }
+
+    static void divexact_1(limb * r, limb const * a, size_t n, limb x)
+    {
+        switch (x)
+        {
+            case 1: std::copy(a, a + n, r); break;
+            case 2: divexact_1<2>(r, a, n); break;
+            case 3: divexact_1<3>(r, a, n); break;
+            case 4: divexact_1<4>(r, a, n); break;
+            case 5: divexact_1<5>(r, a, n); break;
+            default: assert(false);
+        }
+    }
+
+    // r = a + b for signed n-limb values given as magnitude and sign, r may be a or b;
+    // returns the sign of r
+    static bool add_signed(limb * r, limb const * a, bool a_negative, limb const * b, bool b_negative, size_t n)
+    {
+        if (a_negative == b_negative)
+        {
+            limb carry = add_n(r, a, b, n);
+            assert(carry == 0);
+            return a_negative;
+        }
+        return sub_abs(r, a, n, b, n) ? b_negative : a_negative;
+    }
+
+    // Toom-Cook with K pieces: both operands are evaluated as polynomials in B^k at 2K - 2
+    // small integer points and at infinity, the 2K - 1 point products are multiplied
+    // recursively, and the product polynomial is recovered by Newton interpolation. Every
+    // divided difference of an integer polynomial over integer points is an integer, so all
+    // divisions are exact. Toom-3 uses 0, 1, -1, 2 and Toom-4 adds -2 and 3.
+    template <size_t K>
+    static size_t toom_scratch(size_t n)
+    {
+        constexpr size_t points = 2 * K - 2;
+        size_t value_size = (n + K - 1) / K + 1;
+        size_t product_size = 2 * value_size + 1;
+        return 2 * (points + 1) * value_size + (2 * points + 2) * product_size + multiply_scratch(value_size, value_size);
+    }
+
+    // The values, products and coefficients live at the start of the toom_scratch area, the
+    // point products take the rest as their own scratch
+    template <size_t K>
+    static void toom_step(limb * r, limb const * a, limb const * b, size_t n, limb * workspace)
+    {
+        constexpr size_t points = 2 * K - 2;
+        constexpr int xs[] = {0, 1, -1, 2, -2, 3};
+        static_assert(points <= std::size(xs));
+
+        size_t k = (n + K - 1) / K;
+        size_t top = n - (K - 1) * k;
+        assert(top > 0 && top <= k);
+
+        // Values at the points need one limb more than a piece, the products and the
+        // interpolation one more than twice that
+        size_t value_size = k + 1;
+        size_t product_size = 2 * value_size + 1;
+
+        limb * values = workspace;
+        limb * products = values + 2 * (points + 1) * value_size;
+        limb * coefficients = products + (points + 1) * product_size;
+        limb * temp = coefficients + points * product_size;
+        limb * scratch = temp + product_size;
+        std::fill(workspace, scratch, limb{0});
+
+        // A square evaluates its operand once and squares the values
+        bool square = a == b;
+        size_t sides = square ? 1 : 2;
+
+        bool value_negative[2][points + 1]{};
+        bool negative[points + 1]{};
+        bool coefficient_negative[points]{};
+
+        auto piece = [&](limb const * x, size_t i, limb * dst)
+        {
+            size_t length = i == K - 1 ? top : k;
+            std::copy(x + i * k, x + i * k + length, dst);
+            std::fill(dst + length, dst + value_size, limb{0});
+        };
+
+        auto at = [&](limb * base_pointer, size_t i) { return base_pointer + i * product_size; };
+
+        for (size_t side = 0; side < sides; ++side)
+        {
+            limb const * x = side == 0 ? a : b;
+            limb * v = values + side * (points + 1) * value_size;
+
+            for (size_t j = 0; j < points; ++j)
+            {
+                // Horner's scheme from the top piece down
+                limb * dst = v + j * value_size;
+                bool & sign = value_negative[side][j];
+                piece(x, K - 1, dst);
+                for (size_t i = K - 1; i > 0; --i)
+                {
+                    limb carry = mul_1(dst, dst, value_size, static_cast<limb>(std::abs(xs[j])));
+                    assert(carry == 0);
+                    sign = sign != (xs[j] < 0);
+
+                    piece(x, i - 1, temp);
+                    sign = add_signed(dst, dst, sign, temp, false, value_size);
+                }
+            }
+
+            piece(x, K - 1, v + points * value_size);
+        }
+
+        for (size_t j = 0; j <= points; ++j)
+        {
+            limb * w = at(products, j);
+            limb const * x = values + j * value_size;
+            limb const * y = square ? x : values + (points + 1 + j) * value_size;
+            multiply(w, x, value_size, y, value_size, scratch);
+            w[2 * value_size] = 0;
+            negative[j] = value_negative[0][j] != value_negative[sides - 1][j];
+        }
+
+        // Take the known top coefficient out, what is left has degree points - 1
+        limb const * infinity = at(products, points);
+        for (size_t j = 0; j < points; ++j)
+        {
+            limb power = 1;
+            for (size_t i = 0; i < points; ++i)
+            {
+                power *= static_cast<limb>(std::abs(xs[j]));
+            }
+            limb carry = mul_1(temp, infinity, product_size, power);
+            assert(carry == 0);
+
+            limb * w = at(products, j);
+            negative[j] = add_signed(w, w, negative[j], temp, true, product_size);
+        }
+
+        // Divided differences, products[j] becomes f[x_0, ..., x_j]
+        for (size_t level = 1; level < points; ++level)
+        {
+            for (size_t j = points - 1; j >= level; --j)
+            {
+                limb * w = at(products, j);
+                negative[j] = add_signed(w, w, negative[j], at(products, j - 1), !negative[j - 1], product_size);
+
+                int difference = xs[j] - xs[j - level];
+                if (difference != 1 && difference != -1)
+                {
+                    divexact_1(w, w, product_size, static_cast<limb>(std::abs(difference)));
+                }
+                negative[j] = negative[j] != (difference < 0);
+            }
+        }
+
+        // Newton form to monomial form: starting from the innermost divided difference,
+        // multiply by (x - x_j) and add f[x_0, ..., x_j], walking the coefficients from the top
+        std::copy(at(products, points - 1), at(products, points), at(coefficients, 0));
+        coefficient_negative[0] = negative[points - 1];
+        for (size_t j = points - 1; j > 0; --j)
+        {
+            size_t degree = points - 1 - j;
+            limb x = static_cast<limb>(std::abs(xs[j - 1]));
+
+            std::copy(at(coefficients, degree), at(coefficients, degree + 1), at(coefficients, degree + 1));
+            coefficient_negative[degree + 1] = coefficient_negative[degree];
+            for (size_t i = degree + 1; i-- > 0;)
+            {
+                limb carry = mul_1(temp, at(coefficients, i), product_size, x);
+                assert(carry == 0);
+                bool temp_negative = coefficient_negative[i] != (xs[j - 1] < 0);
+
+                if (i == 0)
+                {
+                    std::fill(at(coefficients, 0), at(coefficients, 1), limb{0});
+                    coefficient_negative[0] = add_signed(at(coefficients, 0), at(coefficients, 0), false, temp, !temp_negative, product_size);
+                }
+                else
+                {
+                    coefficient_negative[i] = add_signed(at(coefficients, i), at(coefficients, i - 1), coefficient_negative[i - 1], temp, !temp_negative, product_size);
+                }
+            }
+
+            coefficient_negative[0] = add_signed(at(coefficients, 0), at(coefficients, 0), coefficient_negative[0], at(products, j - 1), negative[j - 1], product_size);
+        }
+
+        // Every coefficient of the product is non-negative, they overlap by product_size - k limbs
+        std::fill(r, r + 2 * n, limb{0});
+        for (size_t i = 0; i <= points; ++i)
+        {
+            limb const * c = i < points ? at(coefficients, i) : infinity;
+            assert(i == points || !coefficient_negative[i] || compare(c, product_size, c, 0) == 0);
+
+            size_t offset = i * k;
+            size_t length = std::min(product_size, 2 * n - offset);
+            assert(compare(c + length, product_size - length, c, 0) == 0);
+
+            limb carry = add(r + offset, r + offset, 2 * n - offset, c, length);
+            assert(carry == 0);
+        }
+    }
+
+    static size_t balanced_scratch(size_t n)
+    {
+        if (n < thresholds.karatsuba || use_ntt(n, n))
+        {
+            return 0;
+        }
+        if (n >= thresholds.toom4)
+        {
+            return toom_scratch<4>(n);
+        }
+        if (n >= thresholds.toom3)
+        {
+            return toom_scratch<3>(n);
+        }
+        return karatsuba_step_scratch(n);
+    }
+
+    // r[0, 2n) = a * b for two n-limb operands by the algorithm the thresholds pick. Every
+    // algorithm takes its squaring shortcut when a and b are the same limbs.
+    static void multiply_balanced(limb * r, limb const * a, limb const * b, size_t n, limb * scratch)
+    {
+        if (n < thresholds.karatsuba)
+        {
+            basecase(r, a, n, b, n);
+        }
+        else if (use_ntt(n, n))
+        {
+            multiply_ntt(r, a, n, b, n);
+        }
+        else if (n >= thresholds.toom4)
+        {
+            toom_step<4>(r, a, b, n, scratch);
+        }
+        else if (n >= thresholds.toom3)
+        {
+            toom_step<3>(r, a, b, n, scratch);
+        }
+        else
+        {
+            karatsuba_step(r, a, b, n, scratch);
+        }
+    }
+
+    static size_t multiply_scratch(size_t an, size_t bn)
+    {
+        if (bn < thresholds.karatsuba || use_ntt(an, bn))
+        {
+            return 0;
+        }
+        if (an == bn)
+        {
+            return balanced_scratch(bn);
+        }
+
+        size_t rest = an % bn;
+        size_t tail = rest == 0 ? 0 : multiply_scratch(bn, rest);
+        return 2 * bn + std::max(balanced_scratch(bn), tail);
+    }
+
+    // r[0, an + bn) = a * b with an >= bn, r must not overlap them. A longer a is cut into
+    // bn-limb pieces whose products are added into r as they come.
+    static void multiply(limb * r, limb const * a, size_t an, limb const * b, size_t bn, limb * scratch)
+    {
+        if (bn < thresholds.karatsuba)
+        {
+            basecase(r, a, an, b, bn);
+            return;
+        }
+
+        if (use_ntt(an, bn))
+        {
+            multiply_ntt(r, a, an, b, bn);
+            return;
+        }
+
+        if (an == bn)
+        {
+            multiply_balanced(r, a, b, bn, scratch);
+            return;
+        }
+
+        limb * piece = scratch;
+        limb * rest = scratch + 2 * bn;
+
+        std::fill(r, r + an + bn, limb{0});
+        for (size_t offset = 0; offset < an; offset += bn)
+        {
+            size_t length = std::min(bn, an - offset);
+            if (length == bn)
+            {
+                multiply_balanced(piece, a + offset, b, bn, rest);
+            }
+            else
+            {
+                multiply(piece, b, bn, a + offset, length, rest);
+            }
+
+            limb carry = add(r + offset, r + offset, an + bn - offset, piece, length + bn);
+            assert(carry == 0);
+        }
+    }
+
+    // multiply with the work spread over a pool: from thresholds.parallel limbs up balanced
+    // products take Karatsuba steps whose three sub-products run as tasks, and the pieces of
+    // an unbalanced product run side by side. Smaller products go to the serial multiply with
+    // a scratch area owned by the thread, as they never wait on other tasks. The arithmetic is
+    // exact, so the result is the one of the serial multiply.
+    static void multiply(ThreadPool & pool, limb * r, limb const * a, size_t an, limb const * b, size_t bn)
+    {
+        if (bn < std::max<size_t>(thresholds.parallel, 2))
+        {
+            thread_local std::vector<limb> scratch;
+            scratch.resize(std::max(scratch.size(), multiply_scratch(an, bn)));
+            multiply(r, a, an, b, bn, scratch.data());
+        }
+        else if (an == bn)
+        {
+            parallel_karatsuba_step(pool, r, a, b, bn);
+        }
+        else
+        {
+            parallel_pieces(pool, r, a, an, b, bn);
+        }
+    }
+
+    // karatsuba_step with the differences in their own buffer, so that all three products
+    // can be written at once
+    static void parallel_karatsuba_step(ThreadPool & pool, limb * r, limb const * a, limb const * b, size_t n)
+    {
+        size_t h = n - n / 2;
+        size_t m = n / 2;
+
+        buffer differences(4 * h + 1, temporary_resource());
+        limb * t = differences.data();
+        limb * da = t + 2 * h + 1;
+        limb * db = da + h;
+
+        auto [x, y, negative] = karatsuba_differences(da, db, a, b, n);
+
+        TaskGroup group{pool};
+        group.run([&] { multiply(pool, r, a, h, b, h); });
+        group.run([&] { multiply(pool, r + 2 * h, a + h, m, b + h, m); });
+        multiply(pool, t, x, h, y, h);
+        group.wait();
+
+        karatsuba_middle(r, t, n, negative);
+    }
+
+    // The bn-limb pieces of a are multiplied as separate tasks. Products of even pieces
+    // tile r without overlapping, the odd ones go to a second buffer added in at the end.
+    static void parallel_pieces(ThreadPool & pool, limb * r, limb const * a, size_t an, limb const * b, size_t bn)
+    {
+        buffer odd(an, 0, temporary_resource());
+        std::fill(r, r + an + bn, limb{0});
+
+        TaskGroup group{pool};
+        for (size_t offset = 0, piece = 0; offset < an; offset += bn, ++piece)
+        {
+            limb * dst = piece % 2 == 0 ? r + offset : odd.data() + offset - bn;
+            size_t length = std::min(bn, an - offset);
+            if (length == bn)
+            {
+                group.run([&pool, dst, a, b, offset, bn] { multiply(pool, dst, a + offset, bn, b, bn); });
+            }
+            else
+            {
+                group.run([&pool, dst, a, b, offset, bn, length] { multiply(pool, dst, b, bn, a + offset, length); });
+            }
+        }
+        group.wait();
+
+        limb carry = add(r + bn, r + bn, an, odd.data(), an);
+        assert(carry == 0);
+    }
+
+    // Divisors of at least this many limbs are divided through a Newton reciprocal, shorter
+    // ones by schoolbook long division
+    static inline size_t newton_threshold = Base::default_newton_threshold;
+
+    // r[0, an + bn) = a * b for operands in any order, with its own scratch
+    static void multiply_any(limb * r, limb const * a, size_t an, limb const * b, size_t bn)
+    {
+        if (an < bn)
+        {
+            std::swap(a, b);
+            std::swap(an, bn);
+        }
+
+        buffer scratch(multiply_scratch(an, bn), temporary_resource());
+        multiply(r, a, an, b, bn, scratch.data());
+    }
+
+    // r -= a * x over n limbs, returns the limb borrowed out
+    static limb submul_1(limb * r, limb const * a, size_t n, limb x)
+    {
+        limb borrow = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            wide product = wide{a[i]} * x + borrow;
+            limb low = static_cast<limb>(product % base);
+            borrow = static_cast<limb>(product / base);
+            if (r[i] < low)
+            {
+                r[i] = static_cast<limb>(r[i] + base - low);
+                ++borrow;
+            }
+            else
+            {
+                r[i] -= low;
+            }
+        }
+        return borrow;
+    }
+
+    // q[0, n) = a / d, returns a % d
+    static limb divrem_1(limb * q, limb const * a, size_t n, limb d)
+    {
+        wide remainder = 0;
+        for (size_t i = n; i > 0; --i)
+        {
+            wide value = remainder * base + a[i - 1];
+            q[i - 1] = static_cast<limb>(value / d);
+            remainder = value % d;
+        }
+        return static_cast<limb>(remainder);
+    }
+
+    // Knuth's algorithm D: q[0, un - vn) = u / v and u[0, vn) becomes u % v. v has vn >= 2
+    // limbs and is normalized, its top limb is at least base / 2, and the top vn limbs of u
+    // are less than v, so that every quotient limb is estimated from the top three limbs of
+    // the window to within one.
+    static void divrem_basecase(limb * q, limb * u, size_t un, limb const * v, size_t vn)
+    {
+        limb top = v[vn - 1];
+        limb next = v[vn - 2];
+
+        for (size_t j = un - vn; j-- > 0;)
+        {
+            wide numerator = wide{u[j + vn]} * base + u[j + vn - 1];
+            wide estimate = std::min<wide>(numerator / top, base - 1);
+            wide rest = numerator - estimate * top;
+            while (rest < base && estimate * next > rest * base + u[j + vn - 2])
+            {
+                --estimate;
+                rest += top;
+            }
+
+            limb digit = static_cast<limb>(estimate);
+            limb borrow = submul_1(u + j, v, vn, digit);
+            if (u[j + vn] < borrow)
+            {
+                --digit;
+                limb carry = add_n(u + j, u + j, v, vn);
+                assert(carry == 1);
+            }
+            u[j + vn] = 0;
+            q[j] = digit;
+        }
+    }
+
+    // x[0, n + 1) = (B^2n - 1) / v for a normalized v of n limbs. The top half of v gives a
+    // reciprocal correct to about half the limbs, one Newton step x + x (B^2n - v x) / B^2n
+    // doubles that, and the few units left are corrected against the exact residue, which
+    // follows from the one of the first half without multiplying by the whole of x again.
+    static void reciprocal(limb * x, limb const * v, size_t n)
+    {
+        if (n < std::max<size_t>(newton_threshold, 2))
+        {
+            buffer u(2 * n + 1, static_cast<limb>(base - 1), temporary_resource());
+            u[2 * n] = 0;
+            if (n == 1)
+            {
+                divrem_1(x, u.data(), 2, v[0]);
+            }
+            else
+            {
+                divrem_basecase(x, u.data(), 2 * n + 1, v, n);
+            }
+            return;
+        }
+
+        size_t h = n - n / 2;
+        size_t l = n - h;
+
+        // x0 = xh B^l from the reciprocal of the top h limbs
+        std::fill(x, x + l, limb{0});
+        reciprocal(x + l, v + l, h);
+
+        // e = B^2n - v x0, positive when x0 is too small
+        buffer e(2 * n + 1, 0, temporary_resource());
+        multiply_any(e.data() + l, v, n, x + l, h + 1);
+        buffer power(2 * n + 1, 0, temporary_resource());
+        power[2 * n] = 1;
+        bool too_large = sub_abs(e.data(), power.data(), 2 * n + 1, e.data(), 2 * n + 1);
+
+        // x0 e / B^2n = xh (e / B^l) / B^2h, the low limbs of e change it by less than one
+        buffer correction(h + 1 + n + 1, temporary_resource());
+        multiply_any(correction.data(), x + l, h + 1, e.data() + l, n + 1);
+        limb const * shifted = correction.data() + 2 * h;
+        size_t shifted_size = correction.size() - 2 * h;
+
+        if (too_large)
+        {
+            limb borrow = sub(x, x, n + 1, shifted, shifted_size);
+            assert(borrow == 0);
+        }
+        else
+        {
+            limb carry = add(x, x, n + 1, shifted, shifted_size);
+            assert(carry == 0);
+        }
+
+        // r = B^2n - 1 - v x = +-(e - v s) - 1 for the step s, walked into [0, v)
+        buffer r(2 * n + 1, 0, temporary_resource());
+        multiply_any(r.data(), v, n, shifted, shifted_size);
+        bool negative = sub_abs(r.data(), e.data(), 2 * n + 1, r.data(), 2 * n + 1) != too_large;
+        if (negative)
+        {
+            limb carry = add_1(r.data(), r.data(), 2 * n + 1, 1);
+            assert(carry == 0);
+        }
+        else if (compare(r.data(), 2 * n + 1, r.data(), 0) == 0)
+        {
+            r[0] = 1;
+            negative = true;
+        }
+        else
+        {
+            sub_1(r.data(), r.data(), 2 * n + 1, 1);
+        }
+
+        while (negative)
+        {
+            limb borrow = sub_1(x, x, n + 1, 1);
+            assert(borrow == 0);
+            negative = !sub_abs(r.data(), r.data(), 2 * n + 1, v, n) && compare(r.data(), 2 * n + 1, r.data(), 0) != 0;
+        }
+        while (compare(r.data(), 2 * n + 1, v, n) >= 0)
+        {
+            limb carry = add_1(x, x, n + 1, 1);
+            assert(carry == 0);
+            sub(r.data(), r.data(), 2 * n + 1, v, n);
+        }
+    }
+
+    // divrem_basecase through the reciprocal x of v: the quotient is found n limbs at a time
+    // from the top. A block of k limbs is estimated from the top k + 1 limbs of the window u
+    // and of x as u x / B^2n, which is never above the true block and at most a few short.
+    // The products of all blocks share one scratch area.
+    static void divrem_newton(limb * q, limb * u, size_t un, limb const * v, size_t n)
+    {
+        buffer x(n + 1, temporary_resource());
+        reciprocal(x.data(), v, n);
+
+        // The first block takes what is left over from whole blocks of n
+        size_t qn = un - n;
+        size_t first = (qn - 1) % n + 1;
+
+        buffer estimate(2 * n + 2, temporary_resource());
+        buffer product(2 * n + 1, temporary_resource());
+        buffer scratch(std::max({multiply_scratch(first + 1, first + 1), multiply_scratch(n + 1, n + 1), multiply_scratch(n, first), multiply_scratch(n, n)}), temporary_resource());
+
+        for (size_t j = qn, k = first; j > 0; j -= k, k = n)
+        {
+            limb * window = u + j - k;
+            limb * digits = q + j - k;
+
+            // The window is less than v B^k, so the block fits k limbs
+            multiply(estimate.data(), window + n - 1, k + 1, x.data() + n - k, k + 1, scratch.data());
+            std::copy(estimate.data() + k + 1, estimate.data() + 2 * k + 1, digits);
+            assert(estimate[2 * k + 1] == 0);
+
+            multiply(product.data(), v, n, digits, k, scratch.data());
+            limb borrow = sub(window, window, n + k, product.data(), n + k);
+            assert(borrow == 0);
+
+            while (compare(window, n + k, v, n) >= 0)
+            {
+                limb carry = add_1(digits, digits, k, 1);
+                assert(carry == 0);
+                sub(window, window, n + k, v, n);
+            }
+        }
+    }
+
+    // q[0, an - bn + 1) = a / b and r[0, bn) = a % b for an >= bn and b without leading zero
+    // limbs. Both operands are scaled by d = base / (b_top + 1), which normalizes b without
+    // changing the quotient, and the remainder is scaled back.
+    static void divrem(limb * q, limb * r, limb const * a, size_t an, limb const * b, size_t bn)
+    {
+        assert(an >= bn && bn > 0 && b[bn - 1] != 0);
+
+        if (bn == 1)
+        {
+            r[0] = divrem_1(q, a, an, b[0]);
+            return;
+        }
+
+        limb d = static_cast<limb>(base / (wide{b[bn - 1]} + 1));
+        buffer v(bn, temporary_resource());
+        buffer u(an + 1, temporary_resource());
+        limb carry = mul_1(v.data(), b, bn, d);
+        assert(carry == 0);
+        u[an] = mul_1(u.data(), a, an, d);
+
+        if (bn < newton_threshold)
+        {
+            divrem_basecase(q, u.data(), an + 1, v.data(), bn);
+        }
+        else
+        {
+            divrem_newton(q, u.data(), an + 1, v.data(), bn);
+        }
+
+        limb remainder = divrem_1(r, u.data(), bn, d);
+        assert(remainder == 0);
+    }
+
+    // Times the algorithms against each other on random operands and moves every threshold
+    // to the first size, on a geometric sweep, from which the next algorithm is faster twice
+    // in a row. Each tier is timed with its sub-products already using the tiers below.
+    // Thresholds with no crossover up to max_size keep their default.
+    static MultiplyThresholds calibrate(size_t max_size = size_t{1} << 14)
+    {
+        constexpr size_t off = SIZE_MAX;
+
+        std::mt19937_64 mt_19937{};
+        std::vector<limb> a(max_size);
+        std::vector<limb> b(max_size);
+        std::vector<limb> r(2 * max_size);
+        for (size_t i = 0; i < max_size; ++i)
+        {
+            a[i] = static_cast<limb>(mt_19937() % base);
+            b[i] = static_cast<limb>(mt_19937() % base);
+        }
+
+        auto time = [](auto && run)
+        {
+            using clock = std::chrono::steady_clock;
+            size_t repeats = 0;
+            auto start = clock::now();
+            auto elapsed = clock::duration{};
+            do
+            {
+                run();
+                ++repeats;
+                elapsed = clock::now() - start;
+            } while (elapsed < std::chrono::milliseconds{2});
+            return std::chrono::duration<double>(elapsed).count() / repeats;
+        };
+
+        // First size from `from` on where faster(n) holds twice in a row
+        auto crossover = [&](size_t from, size_t fallback, auto && faster)
+        {
+            bool previous = false;
+            size_t last = 0;
+            for (size_t n = from; n <= max_size; n += std::max<size_t>(n / 4, 1))
+            {
+                bool now = faster(n);
+                if (now && previous)
+                {
+                    return last;
+                }
+                previous = now;
+                last = n;
+            }
+            return fallback;
+        };
+
+        auto balanced = [&](size_t n)
+        {
+            std::vector<limb> scratch(balanced_scratch(n));
+            return time([&] { multiply_balanced(r.data(), a.data(), b.data(), n, scratch.data()); });
+        };
+
+        constexpr auto defaults = Base::default_thresholds;
+        MultiplyThresholds res{off, off, off, off, thresholds.parallel};
+        thresholds = res;
+
+        res.karatsuba = crossover(4, defaults.karatsuba, [&](size_t n)
+        {
+            std::vector<limb> scratch(karatsuba_step_scratch(n));
+            return time([&] { karatsuba_step(r.data(), a.data(), b.data(), n, scratch.data()); })
+                   < time([&] { mul_basecase(r.data(), a.data(), n, b.data(), n); });
+        });
+        thresholds = res;
+
+        res.toom3 = crossover(std::min(res.karatsuba, max_size) * 3, defaults.toom3, [&](size_t n)
+        {
+            std::vector<limb> scratch(toom_scratch<3>(n));
+            return time([&] { toom_step<3>(r.data(), a.data(), b.data(), n, scratch.data()); }) < balanced(n);
+        });
+        thresholds = res;
+
+        res.toom4 = crossover(std::min(res.toom3, std::min(res.karatsuba, max_size) * 4), defaults.toom4, [&](size_t n)
+        {
+            std::vector<limb> scratch(toom_scratch<4>(n));
+            return time([&] { toom_step<4>(r.data(), a.data(), b.data(), n, scratch.data()); }) < balanced(n);
+        });
+        thresholds = res;
+
+        res.ntt = crossover(std::min(res.karatsuba, max_size), defaults.ntt, [&](size_t n)
+        {
+            return !ntt_fits(n * Base::ntt_pieces, n * Base::ntt_pieces, Base::ntt_piece_base)
+                   || time([&] { multiply_ntt(r.data(), a.data(), n, b.data(), n); }) < balanced(n);
+        });
+        thresholds = res;
+
+        return res;
+    }
+};
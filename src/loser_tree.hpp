@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "fenwick.hpp"
+#include "merge_sort.hpp"
+
+// Tournament tree over k sources that keeps the loser of every match in the inner nodes,
+// so replacing the winner's head costs one comparison per level and no more.
+// less(i, j) tells whether the head of source i is strictly less than the head of source j,
+// an exhausted source has to compare greater than everything. Equal heads go to the lower index.
+template <typename Less>
+class LoserTree
+{
+public:
+    LoserTree(size_t sources, Less less) : sources(sources), less(less)
+    {
+        leaves = 1;
+        while (leaves < sources)
+        {
+            leaves *= 2;
+        }
+
+        tree.assign(leaves, 0);
+
+        std::vector<size_t> winners(leaves * 2);
+        for (size_t i = 0; i < leaves; ++i)
+        {
+            winners[leaves + i] = i;
+        }
+        for (size_t node = leaves - 1; node > 0; --node)
+        {
+            size_t a = winners[node * 2];
+            size_t b = winners[node * 2 + 1];
+            bool a_wins = beats(a, b);
+            winners[node] = a_wins ? a : b;
+            tree[node] = a_wins ? b : a;
+        }
+        tree[0] = winners[1];
+    }
+
+    size_t winner() const { return tree[0]; }
+
+    // Called once the head of the winner has changed or it has run out
+    void replay()
+    {
+        size_t winner = tree[0];
+        for (size_t node = (winner + leaves) / 2; node > 0; node /= 2)
+        {
+            // Selects instead of a branch, the outcome of every match is a coin flip on random data
+            size_t other = tree[node];
+            bool swap = beats(other, winner);
+            tree[node] = swap ? winner : other;
+            winner = swap ? other : winner;
+        }
+        tree[0] = winner;
+    }
+
+private:
+    bool beats(size_t a, size_t b) const
+    {
+        // Padding leaves past the last source never win
+        if (a >= sources)
+        {
+            return false;
+        }
+        if (b >= sources)
+        {
+            return true;
+        }
+        return a < b ? !less(b, a) : less(a, b);
+    }
+
+    size_t sources;
+    size_t leaves;
+    std::vector<size_t> tree;
+    Less less;
+};
+
+// Merges k sorted sources through a loser tree, the in-memory and the on-disk k-way merge
+// alike. sizes[r] is the number of elements of source r, less(i, j) compares the heads of two
+// sources as for LoserTree and take(r) passes the head of source r on and advances it. Ties
+// go to the lower source, so an element taken from source r jumps over everything still left
+// in the sources before r; a Fenwick tree over the sources keeps that count, which is returned.
+template <typename Counter, typename Less, typename Take>
+Counter merge_sources(std::vector<uint64_t> const & sizes, Less less, Take take)
+{
+    size_t k = sizes.size();
+
+    Fenwick<Counter> left{k};
+    uint64_t total = 0;
+    for (size_t r = 0; r < k; ++r)
+    {
+        left.add(r, static_cast<Counter>(sizes[r]));
+        total += sizes[r];
+    }
+
+    LoserTree tree{k, less};
+
+    Counter inversions = 0;
+    for (; total > 0; --total)
+    {
+        size_t r = tree.winner();
+        take(r);
+        inversions += left.prefix(r);
+        left.add(r, Counter{} - 1);
+        tree.replay();
+    }
+
+    return inversions;
+}
+
+// Stable k-way merge of sorted ranges into dst, counting inversions like merge_sources.
+// The ranges are advanced as their elements are taken and are all empty on return.
+template <typename Counter = uint64_t, typename InputIt, typename OutputIt, typename CompFunc>
+Counter kway_merge(std::vector<std::pair<InputIt, InputIt>> & ranges, OutputIt dst, CompFunc comp)
+{
+    std::vector<uint64_t> sizes(ranges.size());
+    for (size_t r = 0; r < ranges.size(); ++r)
+    {
+        sizes[r] = std::distance(ranges[r].first, ranges[r].second);
+    }
+
+    auto less = [&](size_t i, size_t j)
+    {
+        auto const & a = ranges[i];
+        auto const & b = ranges[j];
+        if (a.first == a.second)
+        {
+            return false;
+        }
+        if (b.first == b.second)
+        {
+            return true;
+        }
+        return static_cast<bool>(comp(*a.first, *b.first));
+    };
+
+    return merge_sources<Counter>(sizes, less, [&](size_t r) { *dst++ = std::move(*ranges[r].first++); });
+}
+
+// Runs up to this length are built with binary merges, which are cheap while they stay in cache
+constexpr size_t kway_min_run = 4096;
+
+// Merge sort whose passes above kway_min_run merge fan_in runs at once, so a large input is
+// streamed through memory about log_fan_in(n) times instead of log_2(n) times
+template <std::random_access_iterator RandomIt, typename CompFunc = std::less<>>
+uint64_t kway_merge_sort(RandomIt first, RandomIt last, CompFunc comp = {}, size_t fan_in = 16)
+{
+    size_t size = std::distance(first, last);
+    fan_in = std::max<size_t>(fan_in, 2);
+
+    // Width of the runs after each pass
+    std::vector<size_t> widths{};
+    for (size_t width = 1; width < size;)
+    {
+        width *= width < kway_min_run ? 2 : fan_in;
+        widths.push_back(width);
+    }
+
+    uint64_t inversions = 0;
+
+    size_t skip = 0;
+    if (widths.size() % 2 == 1)
+    {
+        inversions += sort_pairs(first, last, comp);
+        skip = 1;
+    }
+
+    inversions += ping_pong_passes(
+        first,
+        size,
+        widths.size() - skip,
+        [&](auto src, auto dst_at, size_t index)
+        {
+            size_t width = widths[index + skip];
+            size_t run = index + skip == 0 ? 1 : widths[index + skip - 1];
+
+            // One list of runs for the pass, the type of src changes from one pass to the next
+            std::vector<std::pair<decltype(src), decltype(src)>> runs{};
+            runs.reserve(fan_in);
+
+            uint64_t count = 0;
+            for (size_t offset = 0; offset < size; offset += width)
+            {
+                runs.clear();
+                for (size_t run_first = offset; run_first < std::min(offset + width, size); run_first += run)
+                {
+                    runs.emplace_back(src + run_first, src + std::min(run_first + run, size));
+                }
+
+                count += runs.size() == 2 ? ::merge(dst_at(offset), runs[0].first, runs[0].second, runs[1].first, runs[1].second, comp)
+                                          : kway_merge(runs, dst_at(offset), comp);
+            }
+            return count;
+        });
+
+    return inversions;
+}
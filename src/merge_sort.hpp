@@ -1,78 +1,371 @@
 #pragma once
 
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
 #include <vector>
-#include <cmath>
 
+#include "simd_merge.hpp"
+#include "thread_pool.hpp"
+
+// Merges below this size are not worth a call into the vectorized kernel
+constexpr size_t simd_merge_min_size = 32;
+
+// Satisfied when merge can hand its ranges and dst over to simd_merge. For float and double
+// the kernel keeps every value but may swap +0.0 and -0.0, which compare equal.
 template <typename InputIt, typename OutputIt, typename CompFunc>
-inline static int merge(OutputIt dst, InputIt first, InputIt middle, InputIt last, CompFunc comp)
+concept simd_merge_arguments = std::contiguous_iterator<InputIt> && std::contiguous_iterator<OutputIt>
+    && std::same_as<std::iter_value_t<OutputIt>, std::iter_value_t<InputIt>> && simd_mergeable<std::iter_value_t<InputIt>>
+    && (std::same_as<CompFunc, std::less<>> || std::same_as<CompFunc, std::less<std::iter_value_t<InputIt>>>);
+
+// Counter is the accumulator type for inversions: a merge of two halves of n elements
+// can produce up to n^2 / 4 of them, so it has to be wider than the element count
+template <typename Counter = uint64_t, typename InputIt, typename OutputIt, typename CompFunc>
+inline static Counter merge(OutputIt dst, InputIt first1, InputIt last1, InputIt first2, InputIt last2, CompFunc comp)
 {
-    size_t inversions = 0;
+    if constexpr (simd_merge_arguments<InputIt, OutputIt, CompFunc>)
+    {
+        size_t size1 = std::distance(first1, last1);
+        size_t size2 = std::distance(first2, last2);
+        if (size1 + size2 >= simd_merge_min_size)
+        {
+            return static_cast<Counter>(
+                simd_merge(std::to_address(first1), size1, std::to_address(first2), size2, std::to_address(dst)));
+        }
+    }
 
-    auto split = middle;
-    for (; first != split; ++first)
+    Counter inversions = 0;
+
+    for (; first1 != last1; ++first1)
     {
-        for (; middle != last && comp(*middle, *first); ++middle)
+        for (; first2 != last2 && comp(*first2, *first1); ++first2)
         {
-            inversions += std::distance(first, split);
-            *dst++ = *middle;
+            inversions += static_cast<Counter>(std::distance(first1, last1));
+            *dst++ = std::move(*first2);
         }
-        *dst++ = *first;
+        *dst++ = std::move(*first1);
     }
 
-    std::copy(middle, last, dst);
+    std::move(first2, last2, dst);
 
     return inversions;
 }
 
-template <typename T, typename CompFunc>
-std::vector<T> merge_sort(std::vector<T> const & data, CompFunc comp, size_t& inversions)
+template <typename Counter = uint64_t, typename InputIt, typename OutputIt, typename CompFunc>
+inline static Counter merge(OutputIt dst, InputIt first, InputIt middle, InputIt last, CompFunc comp)
+{
+    return ::merge<Counter>(dst, first, middle, middle, last, comp);
+}
+
+// Same count as merge, but nothing is written
+template <typename Counter = uint64_t, typename InputIt, typename CompFunc>
+inline static Counter count_merge_inversions(InputIt first1, InputIt last1, InputIt first2, InputIt last2, CompFunc comp)
+{
+    Counter inversions = 0;
+
+    for (; first2 != last2; ++first2)
+    {
+        for (; first1 != last1 && !comp(*first2, *first1); ++first1)
+        {
+        }
+        inversions += static_cast<Counter>(std::distance(first1, last1));
+    }
+
+    return inversions;
+}
+
+// Number of elements of [first, middle) among the first k elements of the stable merge
+// of [first, middle) and [middle, last), found by binary search along the merge path
+template <typename InputIt, typename CompFunc>
+size_t merge_path_split(InputIt first, InputIt middle, InputIt last, size_t k, CompFunc comp)
+{
+    size_t left_size = std::distance(first, middle);
+    size_t right_size = std::distance(middle, last);
+
+    size_t lo = k > right_size ? k - right_size : 0;
+    size_t hi = std::min(k, left_size);
+
+    // Ties go to the left half, so left[i] belongs to the prefix unless right[k - i - 1] < left[i]
+    while (lo < hi)
+    {
+        size_t i = lo + (hi - lo) / 2;
+        if (comp(*(middle + (k - i - 1)), *(first + i)))
+        {
+            hi = i;
+        }
+        else
+        {
+            lo = i + 1;
+        }
+    }
+
+    return lo;
+}
+
+// First pass of the sort done in place: orders every pair of neighbours
+template <typename RandomIt, typename CompFunc>
+uint64_t sort_pairs(RandomIt first, RandomIt last, CompFunc comp)
+{
+    uint64_t inversions = 0;
+
+    for (; std::distance(first, last) >= 2; first += 2)
+    {
+        if (comp(*(first + 1), *first))
+        {
+            std::iter_swap(first, first + 1);
+            ++inversions;
+        }
+    }
+
+    return inversions;
+}
+
+// Stable insertion sort, every element it shifts is one inversion
+template <typename RandomIt, typename CompFunc>
+uint64_t insertion_sort(RandomIt first, RandomIt last, CompFunc comp)
+{
+    uint64_t inversions = 0;
+
+    if (first == last)
+    {
+        return inversions;
+    }
+
+    for (auto it = first + 1; it != last; ++it)
+    {
+        auto value = std::move(*it);
+        auto hole = it;
+        for (; hole != first && comp(value, *(hole - 1)); --hole)
+        {
+            *hole = std::move(*(hole - 1));
+            ++inversions;
+        }
+        *hole = std::move(value);
+    }
+
+    return inversions;
+}
+
+// Insertion-sorts consecutive blocks of block_size elements
+template <typename RandomIt, typename CompFunc>
+uint64_t sort_blocks(RandomIt first, size_t size, size_t block_size, CompFunc comp)
+{
+    uint64_t inversions = 0;
+    for (size_t offset = 0; offset < size; offset += block_size)
+    {
+        inversions += insertion_sort(first + offset, first + std::min(offset + block_size, size), comp);
+    }
+    return inversions;
+}
+
+// One bottom-up pass merging blocks of `split` elements of [src, src + size) pairwise,
+// dst_at(offset) gives the output iterator for the block starting at offset
+template <typename InputIt, typename DstAt, typename CompFunc>
+uint64_t merge_pass(InputIt src, size_t size, size_t split, DstAt dst_at, CompFunc comp)
+{
+    uint64_t inversions = 0;
+
+    size_t step = split * 2;
+    for (size_t first = 0; first < size; first += step)
+    {
+        size_t middle = std::min(first + split, size);
+        size_t last = std::min(first + step, size);
+        inversions += ::merge(dst_at(first), src + first, src + middle, src + last, comp);
+    }
+
+    return inversions;
+}
+
+// Number of pairwise passes turning runs of `split` elements into one run of `size`
+inline size_t merge_passes(size_t size, size_t split = 1)
+{
+    size_t passes = 0;
+    for (; split < size; split *= 2)
+    {
+        ++passes;
+    }
+    return passes;
+}
+
+// Block size up to block_size for which the passes to sort `size` elements number an even
+// count, or an odd one with `odd` set. If blocks of block_size take p passes, blocks of
+// size / 2^(p + 1) elements, rounded up, take exactly p + 1 and are no larger.
+inline size_t block_size_for_parity(size_t size, size_t block_size, bool odd = false)
+{
+    size_t passes = merge_passes(size, block_size);
+    if (passes % 2 == static_cast<size_t>(odd))
+    {
+        return block_size;
+    }
+    return ((size - 1) >> (passes + 1)) + 1;
+}
+
+// Runs an even number of passes over [first, first + size), moving the elements to a single
+// scratch buffer and back. pass(src, dst_at, index) merges the whole sequence from src into
+// dst_at(offset), writing the offsets in increasing order, and returns its inversions.
+template <typename RandomIt, typename PassFunc>
+uint64_t ping_pong_passes(RandomIt first, size_t size, size_t passes, PassFunc pass)
+{
+    using T = std::iter_value_t<RandomIt>;
+
+    uint64_t inversions = 0;
+    if (passes == 0)
+    {
+        return inversions;
+    }
+
+    if constexpr (std::is_trivially_copyable_v<T> && std::is_trivially_default_constructible_v<T>)
+    {
+        // Nothing to construct, and a contiguous buffer lets merge use the vectorized kernel
+        auto buffer = std::make_unique_for_overwrite<T[]>(size);
+
+        for (size_t i = 0; i < passes; i += 2)
+        {
+            inversions += pass(first, [&](size_t offset) { return buffer.get() + offset; }, i);
+            inversions += pass(buffer.get(), [&](size_t offset) { return first + offset; }, i + 1);
+        }
+    }
+    else
+    {
+        std::vector<T> buffer{};
+        buffer.reserve(size);
+
+        for (size_t i = 0; i < passes; i += 2)
+        {
+            buffer.clear();
+            inversions += pass(first, [&](size_t) { return std::back_inserter(buffer); }, i);
+            inversions += pass(buffer.begin(), [&](size_t offset) { return first + offset; }, i + 1);
+        }
+    }
+
+    return inversions;
+}
+
+struct MergeSortTuning
 {
-    inversions = 0;
-    if (data.empty())
-        return {};
+    // Blocks of this many elements are insertion-sorted before the first merge pass
+    size_t block_size{32};
 
-    std::vector<int> buf1{};
-    buf1.insert(buf1.begin(), data.cbegin(), data.cend());
+    // Bytes a tile may take in cache: the passes over runs shorter than a tile are done
+    // tile by tile, so both the tile and its share of the scratch buffer stay in L2
+    size_t cache_size{size_t{256} << 10};
+};
 
-    std::vector<int> buf2{};
-    buf2.reserve(data.size());
+// Sorts [first, last) in place and returns the number of inversions. Elements are moved
+// back and forth between the range and a single scratch buffer of the same size.
+template <std::random_access_iterator RandomIt, typename CompFunc = std::less<>>
+uint64_t merge_sort(RandomIt first, RandomIt last, CompFunc comp = {}, MergeSortTuning const & tuning = {})
+{
+    using T = std::iter_value_t<RandomIt>;
 
-    // They will be swapped right away
-    auto * dst = &buf1;
-    auto * src = &buf2;
+    size_t size = std::distance(first, last);
+    size_t block_size = std::max<size_t>(tuning.block_size, 2);
+    if (size <= block_size)
+    {
+        return insertion_sort(first, last, comp);
+    }
 
-    size_t depth = std::ceil(std::log2(data.size()));
-    for (int i = 0; i < depth; ++i)
+    uint64_t inversions = 0;
+
+    if constexpr (std::is_trivially_copyable_v<T> && std::is_trivially_default_constructible_v<T>)
     {
-        std::swap(dst, src);
+        // Nothing to construct, and a contiguous buffer lets merge use the vectorized kernel
+        auto buffer = std::make_unique_for_overwrite<T[]>(size);
 
-        dst->clear();
+        size_t tile_size = block_size;
+        while (tile_size * 4 * sizeof(T) <= tuning.cache_size && tile_size < size)
+        {
+            tile_size *= 2;
+        }
 
-        int split = std::floor(std::pow(2, i));
-        int step = split * 2;
+        // Passes go range -> buffer -> range, tiles are left wherever the global passes
+        // have to start for the last of them to write into the range
+        size_t global_passes = merge_passes(size, tile_size);
+        bool start_in_range = global_passes % 2 == 0;
 
-        for (auto first = src->begin(); first <= src->end(); first += step)
+        for (size_t offset = 0; offset < size; offset += tile_size)
         {
-            auto middle = std::min(first + split, src->end());
-            auto last = std::min(first + step, src->end());
-            inversions += merge(std::back_inserter(*dst), first, middle, last, comp);
+            size_t tile = std::min(tile_size, size - offset);
+            auto tile_first = first + offset;
+            auto * tile_buffer = buffer.get() + offset;
+
+            inversions += sort_blocks(tile_first, tile, block_size, comp);
+
+            bool in_range = true;
+            for (size_t split = block_size; split < tile; split *= 2)
+            {
+                if (in_range)
+                {
+                    inversions += merge_pass(tile_first, tile, split, [&](size_t at) { return tile_buffer + at; }, comp);
+                }
+                else
+                {
+                    inversions += merge_pass(tile_buffer, tile, split, [&](size_t at) { return tile_first + at; }, comp);
+                }
+                in_range = !in_range;
+            }
+
+            // The tile is still in cache, so moving it over is cheap
+            if (in_range && !start_in_range)
+            {
+                std::copy(tile_first, tile_first + tile, tile_buffer);
+            }
+            else if (!in_range && start_in_range)
+            {
+                std::copy(tile_buffer, tile_buffer + tile, tile_first);
+            }
+        }
+
+        bool in_range = start_in_range;
+        for (size_t split = tile_size; split < size; split *= 2)
+        {
+            if (in_range)
+            {
+                inversions += merge_pass(first, size, split, [&](size_t at) { return buffer.get() + at; }, comp);
+            }
+            else
+            {
+                inversions += merge_pass(buffer.get(), size, split, [&](size_t at) { return first + at; }, comp);
+            }
+            in_range = !in_range;
         }
     }
+    else
+    {
+        // ping_pong_passes needs an even pass count
+        block_size = block_size_for_parity(size, block_size);
+        inversions += sort_blocks(first, size, block_size, comp);
+        inversions += ping_pong_passes(
+            first,
+            size,
+            merge_passes(size, block_size),
+            [&](auto src, auto dst_at, size_t index) { return merge_pass(src, size, block_size << index, dst_at, comp); });
+    }
+
+    return inversions;
+}
 
-    return *dst;
+template <typename T, typename CompFunc>
+std::vector<T> merge_sort(std::vector<T> const & data, CompFunc comp, size_t& inversions)
+{
+    std::vector<T> res{data};
+    inversions = merge_sort(res.begin(), res.end(), comp);
+    return res;
 }
 
 template <typename T>
 std::vector<T> merge_sort(std::vector<T> const & data) {
     size_t inversions{0};
-    auto simple_compare = [](T a, T b){ return a < b; };
-    return merge_sort(data, simple_compare, inversions);
+    return merge_sort(data, std::less<>{}, inversions);
 }
 
 template <typename T>
 std::vector<T> merge_sort(std::vector<T> const & data, size_t& inversions) {
-    auto simple_compare = [](T a, T b){ return a < b; };
-    return merge_sort(data, simple_compare, inversions);
+    return merge_sort(data, std::less<>{}, inversions);
 }
 
 template <typename T, typename CompFunc>
@@ -81,3 +374,206 @@ std::vector<T> merge_sort(std::vector<T> const & data, CompFunc comp) {
     return merge_sort(data, comp, inversions);
 }
 
+
+// One bottom-up pass over [src, src + size) merging blocks of `split` elements pairwise into dst.
+// Each task merges a run of whole blocks, about one share of them per worker. Only once there
+// are fewer blocks than workers is every merge cut into slices along its merge path. With
+// count_only set dst is never touched.
+template <typename Counter, typename InputIt, typename OutputIt, typename CompFunc>
+Counter parallel_merge_pass(ThreadPool & pool, InputIt src, OutputIt dst, size_t size, size_t split, CompFunc comp, bool count_only)
+{
+    size_t step = split * 2;
+    size_t blocks = (size + step - 1) / step;
+    size_t parts = std::max<size_t>(1, pool.size() / blocks);
+
+    if (parts == 1)
+    {
+        size_t grain = (blocks + pool.size() - 1) / pool.size();
+        std::vector<Counter> partial((blocks + grain - 1) / grain, 0);
+
+        parallel_for(
+            pool,
+            0,
+            blocks,
+            grain,
+            [&](size_t block_first, size_t block_last)
+            {
+                Counter count = 0;
+                for (size_t block = block_first; block < block_last; ++block)
+                {
+                    size_t offset = block * step;
+                    auto first = src + offset;
+                    auto middle = src + std::min(offset + split, size);
+                    auto last = src + std::min(offset + step, size);
+
+                    count += count_only ? count_merge_inversions<Counter>(first, middle, middle, last, comp)
+                                        : ::merge<Counter>(dst + offset, first, middle, last, comp);
+                }
+                partial[block_first / grain] = count;
+            });
+
+        Counter inversions = 0;
+        for (auto count : partial)
+        {
+            inversions += count;
+        }
+
+        return inversions;
+    }
+
+    // Slice boundaries are found before any task starts moving elements out of src
+    std::vector<size_t> left_splits(blocks * (parts + 1), 0);
+    for (size_t block = 0; block < blocks; ++block)
+    {
+        auto first = src + block * step;
+        auto middle = src + std::min(block * step + split, size);
+        auto last = src + std::min(block * step + step, size);
+
+        size_t length = std::distance(first, last);
+        for (size_t part = 0; part <= parts; ++part)
+        {
+            left_splits[block * (parts + 1) + part] = merge_path_split(first, middle, last, length * part / parts, comp);
+        }
+    }
+
+    std::vector<Counter> partial(blocks * parts, 0);
+
+    parallel_for(
+        pool,
+        0,
+        blocks * parts,
+        1,
+        [&](size_t task_first, size_t task_last)
+        {
+            for (size_t task = task_first; task < task_last; ++task)
+            {
+                size_t block = task / parts;
+                size_t part = task % parts;
+
+                size_t offset = block * step;
+                auto first = src + offset;
+                auto middle = src + std::min(offset + split, size);
+                auto last = src + std::min(offset + step, size);
+
+                size_t length = std::distance(first, last);
+                size_t k_first = length * part / parts;
+                size_t k_last = length * (part + 1) / parts;
+
+                size_t i_first = left_splits[block * (parts + 1) + part];
+                size_t i_last = left_splits[block * (parts + 1) + part + 1];
+                size_t j_first = k_first - i_first;
+                size_t j_last = k_last - i_last;
+
+                Counter count = count_only
+                    ? count_merge_inversions<Counter>(first + i_first, first + i_last, middle + j_first, middle + j_last, comp)
+                    : ::merge<Counter>(dst + (offset + k_first), first + i_first, first + i_last, middle + j_first, middle + j_last, comp);
+
+                // Right elements of this slice also jump over the left elements of the later slices
+                size_t left_size = std::distance(first, middle);
+                count += static_cast<Counter>(j_last - j_first) * static_cast<Counter>(left_size - i_last);
+
+                partial[task] = count;
+            }
+        });
+
+    Counter inversions = 0;
+    for (auto count : partial)
+    {
+        inversions += count;
+    }
+
+    return inversions;
+}
+
+// Same result as the sequential merge_sort. Blocks are insertion-sorted and merged on the
+// pool, each task taking a run of whole blocks.
+template <std::random_access_iterator RandomIt, typename CompFunc = std::less<>>
+uint64_t merge_sort(ThreadPool & pool, RandomIt first, RandomIt last, CompFunc comp = {}, MergeSortTuning const & tuning = {})
+{
+    using T = std::iter_value_t<RandomIt>;
+
+    size_t size = std::distance(first, last);
+    size_t block_size = std::max<size_t>(tuning.block_size, 2);
+    if (size <= block_size)
+    {
+        return insertion_sort(first, last, comp);
+    }
+
+    // A buffer of values that cannot be left unconstructed is made by moving the range into
+    // it, then the passes start from the buffer and an odd number of them ends in the range
+    constexpr bool for_overwrite = std::is_trivially_copyable_v<T> && std::is_trivially_default_constructible_v<T>;
+    block_size = block_size_for_parity(size, block_size, !for_overwrite);
+
+    size_t blocks = (size + block_size - 1) / block_size;
+    size_t grain = (blocks + pool.size() - 1) / pool.size();
+    std::vector<uint64_t> partial((blocks + grain - 1) / grain, 0);
+    parallel_for(
+        pool,
+        0,
+        blocks,
+        grain,
+        [&](size_t block_first, size_t block_last)
+        {
+            size_t offset = block_first * block_size;
+            partial[block_first / grain] = sort_blocks(first + offset, std::min(block_last * block_size, size) - offset, block_size, comp);
+        });
+
+    uint64_t inversions = 0;
+    for (auto count : partial)
+    {
+        inversions += count;
+    }
+
+    auto passes = [&](auto from, auto to)
+    {
+        for (size_t split = block_size; split < size; split *= 4)
+        {
+            inversions += parallel_merge_pass<uint64_t>(pool, from, to, size, split, comp, false);
+            if (split * 2 < size)
+            {
+                inversions += parallel_merge_pass<uint64_t>(pool, to, from, size, split * 2, comp, false);
+            }
+        }
+    };
+
+    if constexpr (for_overwrite)
+    {
+        auto buffer = std::make_unique_for_overwrite<T[]>(size);
+        passes(first, buffer.get());
+    }
+    else
+    {
+        std::vector<T> buffer(std::make_move_iterator(first), std::make_move_iterator(last));
+        passes(buffer.begin(), first);
+    }
+
+    return inversions;
+}
+
+template <typename T, typename CompFunc>
+std::vector<T> merge_sort(ThreadPool & pool, std::vector<T> const & data, CompFunc comp, size_t & inversions)
+{
+    std::vector<T> res{data};
+    inversions = merge_sort(pool, res.begin(), res.end(), comp);
+    return res;
+}
+
+template <typename T, typename CompFunc>
+std::vector<T> merge_sort(ThreadPool & pool, std::vector<T> const & data, CompFunc comp)
+{
+    size_t inversions{0};
+    return merge_sort(pool, data, comp, inversions);
+}
+
+template <typename T>
+std::vector<T> merge_sort(ThreadPool & pool, std::vector<T> const & data, size_t & inversions)
+{
+    return merge_sort(pool, data, std::less<>{}, inversions);
+}
+
+template <typename T>
+std::vector<T> merge_sort(ThreadPool & pool, std::vector<T> const & data)
+{
+    size_t inversions{0};
+    return merge_sort(pool, data, inversions);
+}
@@ -0,0 +1,200 @@
+#include "mod_context.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <stdexcept>
+
+#include "limbs.hpp"
+
+namespace
+{
+    using Arithmetic = Limbs<BinaryBase>;
+    using limb = BigNum::limb;
+    using wide = unsigned __int128;
+
+    // Window width for an exponent of `bits` bits, the one with the fewest multiplies for
+    // 2^(w - 1) precomputed odd powers
+    size_t window_width(size_t bits)
+    {
+        size_t width = 1;
+        for (size_t limit : {24, 80, 240, 672})
+        {
+            width += bits > limit;
+        }
+        return width;
+    }
+
+    constexpr size_t max_window_width = 5;
+
+    bool bit(std::vector<limb> const & limbs, size_t i)
+    {
+        return (limbs[i / 64] >> (i % 64)) & 1;
+    }
+}
+
+ModContext::ModContext(BigNum const & modulus) : m(modulus), n(modulus.size())
+{
+    if (m.is_zero() || (m.limbs()[0] & 1) == 0)
+    {
+        throw std::invalid_argument("even modulus");
+    }
+
+    // Newton's iteration for the inverse modulo 2^64 doubles the correct bits every step
+    limb inverse = m.limbs()[0];
+    for (int i = 0; i < 6; ++i)
+    {
+        inverse *= 2 - m.limbs()[0] * inverse;
+    }
+    m_inv = ~inverse + 1;
+
+    std::vector<limb> power(2 * n + 1, 0);
+    power[2 * n] = 1;
+    r2.resize(n, 0);
+    std::ranges::copy(divmod(BigNum{power}, m).second.limbs(), r2.begin());
+
+    product.resize(2 * n + 1);
+    scratch.resize(Arithmetic::multiply_scratch(n, n));
+    table.resize((size_t{1} << (max_window_width - 1)) * n);
+    operand.resize(n);
+    accumulator.resize(n);
+
+    // R mod m is the Montgomery form of one, and the reduction of R^2
+    one = r2;
+    std::fill(product.begin(), product.end(), limb{0});
+    std::copy(r2.begin(), r2.end(), product.begin());
+    redc(one.data());
+}
+
+// r[0, n) = x mod m, dividing only if x is not reduced already
+void ModContext::reduced(BigNum const & x, limb * r) const
+{
+    std::fill(r, r + n, limb{0});
+    if (x < m)
+    {
+        std::ranges::copy(x.limbs(), r);
+    }
+    else
+    {
+        std::ranges::copy(divmod(x, m).second.limbs(), r);
+    }
+}
+
+// r[0, n) = product R^-1 mod m for a product below m R, clearing one limb a row from the bottom.
+// The carry out of row i lands on limb i + n, which no earlier row touches again.
+void ModContext::redc(limb * r)
+{
+    limb * t = product.data();
+    limb const * modulus = m.limbs().data();
+
+    limb high = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        limb carry = Arithmetic::addmul_1(t + i, modulus, n, t[i] * m_inv);
+        wide sum = wide{t[i + n]} + carry + high;
+        t[i + n] = static_cast<limb>(sum);
+        high = static_cast<limb>(sum >> 64);
+    }
+
+    // The result is below 2m, with its top bit in `high`
+    if (high != 0 || Arithmetic::compare(t + n, n, modulus, n) >= 0)
+    {
+        Arithmetic::sub_n(t + n, t + n, modulus, n);
+    }
+    std::copy(t + n, t + 2 * n, r);
+}
+
+// r = a b R^-1 mod m, the product squares when a and b are the same limbs
+void ModContext::mont_multiply(limb * r, limb const * a, limb const * b)
+{
+    Arithmetic::multiply(product.data(), a, n, b, n, scratch.data());
+    product[2 * n] = 0;
+    redc(r);
+}
+
+BigNum ModContext::mulmod(BigNum const & lhs, BigNum const & rhs)
+{
+    reduced(lhs, operand.data());
+    reduced(rhs, accumulator.data());
+
+    // (a b R^-1) R^2 R^-1 = a b
+    mont_multiply(accumulator.data(), operand.data(), accumulator.data());
+    mont_multiply(accumulator.data(), accumulator.data(), r2.data());
+    return BigNum{accumulator};
+}
+
+BigNum ModContext::sqrmod(BigNum const & x)
+{
+    reduced(x, accumulator.data());
+    mont_multiply(accumulator.data(), accumulator.data(), accumulator.data());
+    mont_multiply(accumulator.data(), accumulator.data(), r2.data());
+    return BigNum{accumulator};
+}
+
+BigNum ModContext::powmod(BigNum const & base, BigNum const & exponent)
+{
+    auto const & e = exponent.limbs();
+    size_t bits = e.empty() ? 0 : 64 * e.size() - std::countl_zero(e.back());
+    size_t width = std::min(window_width(bits), max_window_width);
+
+    // table[k] = base^(2k + 1) in Montgomery form
+    reduced(base, operand.data());
+    limb * powers = table.data();
+    mont_multiply(powers, operand.data(), r2.data());
+    mont_multiply(operand.data(), powers, powers);
+    for (size_t k = 1; k < (size_t{1} << (width - 1)); ++k)
+    {
+        mont_multiply(powers + k * n, powers + (k - 1) * n, operand.data());
+    }
+
+    std::copy(one.begin(), one.end(), accumulator.begin());
+    limb * acc = accumulator.data();
+    bool started = false;
+
+    for (size_t i = bits; i > 0;)
+    {
+        if (!bit(e, i - 1))
+        {
+            if (started)
+            {
+                mont_multiply(acc, acc, acc);
+            }
+            --i;
+            continue;
+        }
+
+        // Longest window of at most `width` bits from bit i - 1 down that ends on a set bit
+        size_t low = i > width ? i - width : 0;
+        while (!bit(e, low))
+        {
+            ++low;
+        }
+
+        size_t value = 0;
+        for (size_t j = i; j > low; --j)
+        {
+            value = value * 2 + bit(e, j - 1);
+            if (started)
+            {
+                mont_multiply(acc, acc, acc);
+            }
+        }
+
+        if (started)
+        {
+            mont_multiply(acc, acc, powers + (value / 2) * n);
+        }
+        else
+        {
+            std::copy(powers + (value / 2) * n, powers + (value / 2 + 1) * n, acc);
+            started = true;
+        }
+        i = low;
+    }
+
+    // Out of Montgomery form: one more reduction of the value itself
+    std::fill(product.begin(), product.end(), limb{0});
+    std::copy(acc, acc + n, product.begin());
+    redc(acc);
+    return BigNum{accumulator};
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "bignum.hpp"
+
+// Arithmetic modulo a fixed odd modulus in Montgomery form, R = 2^(64 n) for a modulus of n
+// limbs. The constants are computed once per modulus, and every product works in buffers
+// owned by the context, so the exponent loop of powmod does not allocate. A context is not
+// safe to share between threads.
+class ModContext
+{
+public:
+    // Throws std::invalid_argument for an even modulus
+    explicit ModContext(BigNum const & modulus);
+
+    BigNum const & modulus() const { return m; }
+
+    // Operands need not be reduced, though reducing them costs a division
+    BigNum mulmod(BigNum const & lhs, BigNum const & rhs);
+    BigNum sqrmod(BigNum const & n);
+
+    // base^exponent mod m by left-to-right sliding windows over the exponent bits
+    BigNum powmod(BigNum const & base, BigNum const & exponent);
+
+private:
+    using limb = BigNum::limb;
+
+    void reduced(BigNum const & x, limb * r) const;
+    void redc(limb * r);
+    void mont_multiply(limb * r, limb const * a, limb const * b);
+
+    BigNum m;
+    size_t n;
+    limb m_inv;
+
+    // R^2 mod m turns a reduced value into Montgomery form, R mod m is the form of one
+    std::vector<limb> r2;
+    std::vector<limb> one;
+
+    // product holds a 2n-limb product and its carry limb, table the odd powers of powmod
+    std::vector<limb> product;
+    std::vector<limb> scratch;
+    std::vector<limb> table;
+    std::vector<limb> operand;
+    std::vector<limb> accumulator;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+// Operand sizes, in limbs, from which multiply switches to each algorithm. Below karatsuba
+// the schoolbook product is used; SIZE_MAX turns an algorithm off. The multiply on a thread
+// pool forks Karatsuba sub-products as tasks down to `parallel` limbs.
+struct MultiplyThresholds
+{
+    size_t karatsuba;
+    size_t toom3;
+    size_t toom4;
+    size_t ntt;
+    size_t parallel;
+};
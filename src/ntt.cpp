@@ -0,0 +1,241 @@
+#include "ntt.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <memory_resource>
+#include <vector>
+
+#include "arena.hpp"
+
+namespace
+{
+    using wide = unsigned __int128;
+
+    // Arithmetic modulo a prime P < 2^31 in Montgomery form, R = 2^32
+    template <uint32_t P, uint32_t Generator>
+    struct Field
+    {
+        static constexpr uint32_t modulus = P;
+
+        static constexpr uint32_t neg_inv = []
+        {
+            uint32_t inv = P;
+            for (int i = 0; i < 4; ++i)
+            {
+                inv *= 2 - P * inv;
+            }
+            return ~inv + 1;
+        }();
+
+        static constexpr uint32_t r2 = static_cast<uint32_t>((wide{1} << 64) % P);
+
+        static uint32_t reduce(uint64_t t)
+        {
+            uint32_t m = static_cast<uint32_t>(t) * neg_inv;
+            uint32_t u = static_cast<uint32_t>((t + uint64_t{m} * P) >> 32);
+            return u >= P ? u - P : u;
+        }
+
+        static uint32_t to(uint32_t a) { return reduce(uint64_t{a} * r2); }
+        static uint32_t mul(uint32_t a, uint32_t b) { return reduce(uint64_t{a} * b); }
+
+        static uint32_t add(uint32_t a, uint32_t b)
+        {
+            uint32_t s = a + b;
+            return s >= P ? s - P : s;
+        }
+
+        static uint32_t sub(uint32_t a, uint32_t b) { return a >= b ? a - b : a + P - b; }
+
+        static uint32_t pow(uint32_t a, uint64_t e)
+        {
+            uint32_t res = to(1);
+            for (; e > 0; e >>= 1)
+            {
+                if (e & 1)
+                {
+                    res = mul(res, a);
+                }
+                a = mul(a, a);
+            }
+            return res;
+        }
+
+        // roots[len + j] = w^j for the 2 len-th root of unity w, for every len up to size / 2,
+        // so each butterfly level reads its twiddles contiguously
+        static std::pmr::vector<uint32_t> roots(size_t size, bool inverse)
+        {
+            std::pmr::vector<uint32_t> res(std::max<size_t>(size, 2), temporary_resource());
+            for (size_t len = 1; len < size; len *= 2)
+            {
+                uint32_t w = pow(to(Generator), (P - 1) / (2 * len));
+                if (inverse)
+                {
+                    w = pow(w, P - 2);
+                }
+                res[len] = to(1);
+                for (size_t j = 1; j < len; ++j)
+                {
+                    res[len + j] = mul(res[len + j - 1], w);
+                }
+            }
+            return res;
+        }
+
+        // Decimation in frequency, natural order in, bit-reversed order out
+        static void forward(uint32_t * a, size_t size, std::pmr::vector<uint32_t> const & roots)
+        {
+            for (size_t len = size / 2; len > 0; len /= 2)
+            {
+                uint32_t const * w = roots.data() + len;
+                for (size_t i = 0; i < size; i += 2 * len)
+                {
+                    for (size_t j = 0; j < len; ++j)
+                    {
+                        uint32_t u = a[i + j];
+                        uint32_t v = a[i + j + len];
+                        a[i + j] = add(u, v);
+                        a[i + j + len] = mul(sub(u, v), w[j]);
+                    }
+                }
+            }
+        }
+
+        // Decimation in time, bit-reversed order in, natural order out, not yet scaled by 1 / size
+        static void inverse(uint32_t * a, size_t size, std::pmr::vector<uint32_t> const & roots)
+        {
+            for (size_t len = 1; len < size; len *= 2)
+            {
+                uint32_t const * w = roots.data() + len;
+                for (size_t i = 0; i < size; i += 2 * len)
+                {
+                    for (size_t j = 0; j < len; ++j)
+                    {
+                        uint32_t u = a[i + j];
+                        uint32_t v = mul(a[i + j + len], w[j]);
+                        a[i + j] = add(u, v);
+                        a[i + j + len] = sub(u, v);
+                    }
+                }
+            }
+        }
+
+        // Cyclic convolution of a and b modulo P, in plain form. A square takes one forward
+        // transform.
+        static std::pmr::vector<uint32_t> convolve(uint32_t const * a, size_t an, uint32_t const * b, size_t bn, size_t size)
+        {
+            bool square = a == b && an == bn;
+
+            std::pmr::vector<uint32_t> fa(size, 0, temporary_resource());
+            std::pmr::vector<uint32_t> fb(square ? 0 : size, 0, temporary_resource());
+            std::transform(a, a + an, fa.begin(), [](uint32_t x) { return to(x % P); });
+            std::transform(b, b + (square ? 0 : bn), fb.begin(), [](uint32_t x) { return to(x % P); });
+
+            auto forward_roots = roots(size, false);
+            forward(fa.data(), size, forward_roots);
+            if (!square)
+            {
+                forward(fb.data(), size, forward_roots);
+            }
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                fa[i] = mul(fa[i], square ? fa[i] : fb[i]);
+            }
+
+            inverse(fa.data(), size, roots(size, true));
+
+            // Multiplying a Montgomery value by a plain one leaves the plain product
+            uint32_t scale = reduce(pow(to(static_cast<uint32_t>(size)), P - 2));
+            for (auto & x : fa)
+            {
+                x = mul(x, scale);
+            }
+            return fa;
+        }
+    };
+
+    using Field1 = Field<2013265921, 31>;
+    using Field2 = Field<469762049, 3>;
+    using Field3 = Field<167772161, 3>;
+
+    uint32_t pow_mod(uint64_t a, uint64_t e, uint64_t p)
+    {
+        uint64_t res = 1;
+        for (a %= p; e > 0; e >>= 1)
+        {
+            if (e & 1)
+            {
+                res = res * a % p;
+            }
+            a = a * a % p;
+        }
+        return static_cast<uint32_t>(res);
+    }
+}
+
+bool ntt_fits(size_t an, size_t bn, uint64_t base)
+{
+    constexpr size_t max_size = size_t{1} << 25;
+    constexpr wide modulus = wide{Field1::modulus} * Field2::modulus * Field3::modulus;
+
+    wide largest = wide{base - 1} * (base - 1);
+    return an + bn <= max_size && wide{std::min(an, bn)} < modulus / largest;
+}
+
+void ntt_multiply(uint32_t const * a, size_t an, uint32_t const * b, size_t bn, uint64_t base, uint32_t * out)
+{
+    assert(ntt_fits(an, bn, base));
+
+    std::fill(out, out + an + bn, uint32_t{0});
+    if (an == 0 || bn == 0)
+    {
+        return;
+    }
+
+    size_t size = 1;
+    while (size < an + bn - 1)
+    {
+        size *= 2;
+    }
+
+    auto r1 = Field1::convolve(a, an, b, bn, size);
+    auto r2 = Field2::convolve(a, an, b, bn, size);
+    auto r3 = Field3::convolve(a, an, b, bn, size);
+
+    constexpr uint64_t p1 = Field1::modulus;
+    constexpr uint64_t p2 = Field2::modulus;
+    constexpr uint64_t p3 = Field3::modulus;
+
+    // Garner's mixed radix form x = x1 + p1 (k2 + p2 k3)
+    const uint64_t p1_inv_p2 = pow_mod(p1, p2 - 2, p2);
+    const uint64_t p12_inv_p3 = pow_mod(p1 * p2 % p3, p3 - 2, p3);
+
+    wide carry = 0;
+    for (size_t k = 0; k < an + bn; ++k)
+    {
+        if (k < an + bn - 1)
+        {
+            uint64_t x1 = r1[k];
+            uint64_t k2 = (r2[k] + p2 - x1 % p2) % p2 * p1_inv_p2 % p2;
+            uint64_t x12 = x1 + p1 * k2;
+            uint64_t k3 = (r3[k] + p3 - x12 % p3) % p3 * p12_inv_p3 % p3;
+            carry += x12 + wide{p1 * p2} * k3;
+        }
+
+        // Long division of the 128-bit carry by a 32-bit base in 32-bit steps keeps every
+        // division within 64 bits
+        uint64_t high = static_cast<uint64_t>(carry >> 64);
+        uint64_t low = static_cast<uint64_t>(carry);
+        uint64_t q_high = high / base;
+        uint64_t rest = ((high % base) << 32) | (low >> 32);
+        uint64_t q_mid = rest / base;
+        rest = ((rest % base) << 32) | (low & 0xffffffff);
+        uint64_t q_low = rest / base;
+
+        out[k] = static_cast<uint32_t>(rest % base);
+        carry = (wide{q_high} << 64) + (wide{q_mid} << 32) + q_low;
+    }
+
+    assert(carry == 0);
+}
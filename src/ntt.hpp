@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Whether ntt_multiply can take operands of an and bn digits in base `base`: the product
+// must fit the longest transform, and no coefficient of the convolution may reach the
+// product of the three primes
+bool ntt_fits(size_t an, size_t bn, uint64_t base);
+
+// out[0, an + bn) = a * b for little-endian digits in base `base` (at most 2^32). The
+// convolution is done by number-theoretic transforms modulo three primes below 2^31 and
+// recombined exactly with the Chinese remainder theorem. Passing the same digits as a and
+// b squares them with one forward transform per prime instead of two.
+void ntt_multiply(uint32_t const * a, size_t an, uint32_t const * b, size_t bn, uint64_t base, uint32_t * out);
@@ -1,35 +1,42 @@
 #include "product.hpp"
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
-#include <execution>
 #include <stdexcept>
+#include <tuple>
+#include <vector>
 
+#include "arena.hpp"
+#include "digits.hpp"
+#include "interleaved.hpp"
+#include "limbs.hpp"
+
+// Checking and converting is a single pass of the vectorized digit kernels
 bigint bigint_from_string(std::string const & str)
 {
     bigint res(str.size());
 
-    const bool check = std::all_of(std::execution::unseq, str.cbegin(), str.cend(), [](auto n) { return n >= 48 && n <= 57; });
+    const bool check = digits_from_chars(str.data(), str.size(), res.data());
     if (!check)
     {
         throw std::invalid_argument("nonint character");
     }
 
-    std::transform(std::execution::unseq, str.cbegin(), str.cend(), res.begin(), [](auto c) { return c - 48; });
-
     return res;
 }
 
 std::string string_from_bigint(bigint const & n)
 {
-    const bool check = std::all_of(std::execution::unseq, n.cbegin(), n.cend(), [](auto n) { return n >= 0 && n <= 9; });
+    std::string res(n.size(), '\0');
+
+    const bool check = chars_from_digits(n.data(), n.size(), res.data());
     if (!check)
     {
         throw std::invalid_argument("non-char integer");
     }
 
-    std::string res(n.size(), '\0');
-    std::transform(std::execution::unseq, n.cbegin(), n.cend(), res.begin(), [](auto n) { return n + 48; });
     return res;
 }
 
@@ -38,6 +45,19 @@ inline bool not_zero(uint8_t x)
     return x != 0;
 }
 
+std::strong_ordering compare(bigint const & lhs, bigint const & rhs)
+{
+    auto a = std::find_if(lhs.begin(), lhs.end(), not_zero);
+    auto b = std::find_if(rhs.begin(), rhs.end(), not_zero);
+    if (lhs.end() - a != rhs.end() - b)
+    {
+        return lhs.end() - a <=> rhs.end() - b;
+    }
+
+    auto [x, y] = std::mismatch(a, lhs.end(), b);
+    return x == lhs.end() ? std::strong_ordering::equal : *x <=> *y;
+}
+
 std::pair<uint8_t, uint8_t> add(uint8_t a, uint8_t b, uint8_t carry)
 {
     uint8_t res = a + b + carry;
@@ -56,155 +76,534 @@ std::pair<uint8_t, uint8_t> subtract(uint8_t a, uint8_t b, uint8_t carry)
 }
 
 
-bigint add(bigint const & lhs, bigint const & rhs)
+void add_shifted(bigint & acc, bigint const & x, size_t shift)
 {
-    auto as = lhs;
-    auto bs = rhs;
+    if (&acc == &x)
+    {
+        auto const copy = x;
+        add_shifted(acc, copy, shift);
+        return;
+    }
 
-    // `as` should be longer or the same as `bs`
-    if (as.size() < bs.size())
+    if (x.empty())
     {
-        std::swap(as, bs);
+        return;
     }
 
-    bigint res{};
-    res.reserve(as.size() + 1); // the res cannot be any longer than bs.size() + 1
+    // Leading zeros up to the length of the shifted x, then one more digit for a final carry
+    size_t const size = std::max(acc.size(), x.size() + shift);
+    acc.insert(acc.begin(), size - acc.size(), 0);
 
     uint8_t carry = 0;
 
-    auto a = as.crbegin();
-    for (auto b = bs.crbegin(); b < bs.crend(); ++a, ++b)
+    auto a = acc.rbegin() + shift;
+    for (auto b = x.crbegin(); b < x.crend(); ++a, ++b)
     {
         auto [r, new_carry] = add(*a, *b, carry);
-        res.push_back(r);
+        *a = r;
         carry = new_carry;
     }
 
-    for (; a < as.crend(); ++a)
+    for (; carry && a < acc.rend(); ++a)
     {
         auto [r, new_carry] = add(*a, 0, carry);
-        res.push_back(r);
+        *a = r;
         carry = new_carry;
     }
 
     if (carry)
     {
-        res.push_back(carry);
+        acc.insert(acc.begin(), carry);
     }
-
-    std::reverse(res.begin(), res.end());
-    return res;
 }
 
-bigint subtract(bigint const & as, bigint const & bs)
+void add_to(bigint & acc, bigint const & x)
 {
-    assert(as.size() >= bs.size());
+    add_shifted(acc, x, 0);
+}
 
-    bigint res{};
-    res.reserve(as.size());
+void sub_from(bigint & acc, bigint const & x)
+{
+    assert(acc.size() >= x.size());
 
     uint8_t carry = 0;
 
-    auto a = as.crbegin();
-    for (auto b = bs.crbegin(); b < bs.crend(); ++b, ++a)
+    auto a = acc.rbegin();
+    for (auto b = x.crbegin(); b < x.crend(); ++a, ++b)
     {
         auto [r, new_carry] = subtract(*a, *b, carry);
-        res.push_back(r);
+        *a = r;
         carry = new_carry;
     }
 
-    for (; a < as.crend(); ++a)
+    for (; carry && a < acc.rend(); ++a)
     {
         auto [r, new_carry] = subtract(*a, 0, carry);
-        res.push_back(r);
+        *a = r;
         carry = new_carry;
     }
 
     assert(carry == 0);
 
-    auto trailing_zeros_end = std::find_if(res.crbegin(), res.crend(), not_zero);
-    res.erase(trailing_zeros_end.base(), res.end());
-    std::reverse(res.begin(), res.end());
+    acc.erase(acc.begin(), std::find_if(acc.begin(), acc.end(), not_zero));
+}
 
+// The longer operand is copied once into a buffer with room for the carry
+bigint add(bigint const & lhs, bigint const & rhs)
+{
+    auto const & as = lhs.size() < rhs.size() ? rhs : lhs;
+    auto const & bs = lhs.size() < rhs.size() ? lhs : rhs;
+
+    bigint res{};
+    res.reserve(as.size() + 1);
+    res.assign(as.begin(), as.end());
+
+    add_to(res, bs);
     return res;
 }
 
-std::pair<bigint, bigint> split(bigint const & val, size_t n)
+bigint add(bigint && lhs, bigint const & rhs)
+{
+    add_to(lhs, rhs);
+    return std::move(lhs);
+}
+
+bigint add(bigint const & lhs, bigint && rhs)
+{
+    add_to(rhs, lhs);
+    return std::move(rhs);
+}
+
+bigint add(bigint && lhs, bigint && rhs)
 {
-    if (val.empty())
+    if (lhs.capacity() < rhs.capacity())
     {
-        return {bigint{}, bigint{}};
+        return add(lhs, std::move(rhs));
     }
 
-    if (val.size() <= n)
+    return add(std::move(lhs), rhs);
+}
+
+bigint subtract(bigint const & lhs, bigint const & rhs)
+{
+    auto res = lhs;
+    sub_from(res, rhs);
+    return res;
+}
+
+bigint subtract(bigint && lhs, bigint const & rhs)
+{
+    sub_from(lhs, rhs);
+    return std::move(lhs);
+}
+
+// The difference is written over the digits of rhs, widened to the length of lhs
+bigint subtract(bigint const & lhs, bigint && rhs)
+{
+    assert(lhs.size() >= rhs.size());
+
+    rhs.insert(rhs.begin(), lhs.size() - rhs.size(), 0);
+
+    uint8_t carry = 0;
+
+    auto a = lhs.crbegin();
+    for (auto b = rhs.rbegin(); b < rhs.rend(); ++a, ++b)
     {
-        return {bigint{}, val};
+        auto [r, new_carry] = subtract(*a, *b, carry);
+        *b = r;
+        carry = new_carry;
     }
 
-    bigint a{};
-    a.reserve(val.size() - n);
-    bigint b{};
-    b.reserve(n);
+    assert(carry == 0);
 
-    std::copy(val.cbegin(), val.cend() - n, std::back_inserter(a));
+    rhs.erase(rhs.begin(), std::find_if(rhs.begin(), rhs.end(), not_zero));
+    return std::move(rhs);
+}
 
-    auto leading_zeros_end = std::find_if(val.cend() - n, val.cend(), not_zero);
-    std::copy(leading_zeros_end, val.cend(), std::back_inserter(b));
+bigint subtract(bigint && lhs, bigint && rhs)
+{
+    if (lhs.capacity() < rhs.capacity())
+    {
+        return subtract(lhs, std::move(rhs));
+    }
 
-    return {a, b};
+    return subtract(std::move(lhs), rhs);
 }
 
-bigint power_ten(bigint const & val, uint8_t power)
+namespace
 {
-    if (val.empty())
+    using Decimal = Limbs<DecimalBase>;
+    using limb = Decimal::limb;
+
+    size_t limb_count(bigint const & n)
     {
-        return val;
+        return (n.size() + DecimalBase::digits - 1) / DecimalBase::digits;
     }
 
-    auto res = val;
-    res.reserve(res.size() + power);
+    // Groups of 9 digits from the least significant end, limb i at out[i * stride]
+    template <typename T>
+    void limbs_from_bigint(bigint const & n, T * out, size_t stride = 1)
+    {
+        size_t last = n.size();
+        for (size_t i = 0; last > 0; ++i)
+        {
+            size_t first = last - std::min(last, DecimalBase::digits);
+            out[i * stride] = static_cast<T>(pack_digits(n.data() + first, last - first));
+            last = first;
+        }
+    }
 
-    for (uint8_t i = 0; i < power; ++i)
+    Decimal::buffer limbs_from_bigint(bigint const & n)
     {
-        res.push_back(0);
+        Decimal::buffer res(limb_count(n), temporary_resource());
+        limbs_from_bigint(n, res.data());
+        return res;
     }
 
-    return res;
+    // Sized from the top limb, so a short result never passes through a longer buffer
+    template <typename T>
+    bigint bigint_from_limbs(T const * limbs, size_t n, size_t stride = 1)
+    {
+        while (n > 0 && limbs[(n - 1) * stride] == 0)
+        {
+            --n;
+        }
+
+        if (n == 0)
+        {
+            return {};
+        }
+
+        size_t top_digits = 1;
+        for (T x = limbs[(n - 1) * stride]; x >= 10; x /= 10)
+        {
+            ++top_digits;
+        }
+
+        bigint res((n - 1) * DecimalBase::digits + top_digits);
+
+        // The top limb without its leading zeros, then 9 digits for each limb below
+        uint8_t * digit = res.data() + top_digits;
+        for (T x = limbs[(n - 1) * stride], i = top_digits; i > 0; --i, x /= 10)
+        {
+            res[i - 1] = static_cast<uint8_t>(x % 10);
+        }
+        for (size_t i = n - 1; i-- > 0; digit += DecimalBase::digits)
+        {
+            uint64_t x = limbs[i * stride];
+            digit[0] = static_cast<uint8_t>(x / 100'000'000);
+            unpack_eight_digits(x % 100'000'000, digit + 1);
+        }
+
+        return res;
+    }
+
+    bigint bigint_from_limbs(Decimal::buffer const & limbs)
+    {
+        return bigint_from_limbs(limbs.data(), limbs.size());
+    }
+
+    // Stack space for the temporaries of an operation, enough for a few hundred digits
+    constexpr size_t local_arena_size = 1024;
+
+    // Peak bytes of the temporaries of a product of an >= bn limbs: the operands, the result
+    // and the scratch area, or the pieces and the transforms, which keep at most six
+    // transform-sized vectors of 32-bit words alive at once
+    size_t multiply_arena_size(size_t an, size_t bn)
+    {
+        size_t n = an + bn;
+        size_t words = 2 * n + Decimal::multiply_scratch(an, bn);
+        if (Decimal::use_ntt(an, bn))
+        {
+            words += 2 * n + 12 * std::bit_ceil(n);
+        }
+        return words * sizeof(limb) + 256;
+    }
+
+    // The dividend twice, the divisor and its reciprocal with the residues of the Newton
+    // steps, which sum to about twice the top step, and one product
+    size_t divmod_arena_size(size_t an, size_t bn)
+    {
+        return (3 * an + 24 * bn) * sizeof(limb) + multiply_arena_size(2 * bn + 2, bn + 1);
+    }
 }
 
+// The digits are packed into base 10^9 limbs, multiplied by Limbs::multiply into a single
+// result buffer with one scratch area, and unpacked again
 bigint multiply(bigint const & lhs, bigint const & rhs)
 {
-    if (lhs.empty() || rhs.empty())
+    return multiply(lhs, rhs, std::pmr::get_default_resource());
+}
+
+bigint multiply(bigint const & lhs, bigint const & rhs, std::pmr::memory_resource * upstream)
+{
+    if (&lhs == &rhs)
+    {
+        return square(lhs, upstream);
+    }
+
+    alignas(std::max_align_t) std::array<std::byte, local_arena_size> local;
+    ArenaScope arena{local, multiply_arena_size(std::max(limb_count(lhs), limb_count(rhs)), std::min(limb_count(lhs), limb_count(rhs))), upstream};
+
+    auto as = limbs_from_bigint(lhs);
+    auto bs = limbs_from_bigint(rhs);
+    if (as.size() < bs.size())
+    {
+        std::swap(as, bs);
+    }
+
+    if (bs.empty())
     {
         return {};
     }
 
-    if (lhs.size() <= 1 && rhs.size() <= 1)
+    Decimal::buffer res(as.size() + bs.size(), temporary_resource());
+    Decimal::buffer scratch(Decimal::multiply_scratch(as.size(), bs.size()), temporary_resource());
+    Decimal::multiply(res.data(), as.data(), as.size(), bs.data(), bs.size(), scratch.data());
+
+    return bigint_from_limbs(res);
+}
+
+bigint square(bigint const & n)
+{
+    return square(n, std::pmr::get_default_resource());
+}
+
+// Every algorithm takes its squaring shortcut when both operands are the same limbs
+bigint square(bigint const & n, std::pmr::memory_resource * upstream)
+{
+    alignas(std::max_align_t) std::array<std::byte, local_arena_size> local;
+    ArenaScope arena{local, multiply_arena_size(limb_count(n), limb_count(n)), upstream};
+
+    auto as = limbs_from_bigint(n);
+    if (as.empty())
     {
-        uint8_t a_number = lhs.size() == 1 ? lhs.front() : 0;
-        uint8_t b_number = rhs.size() == 1 ? rhs.front() : 0;
-        uint8_t res = a_number * b_number;
-        if (res < 10)
+        return {};
+    }
+
+    Decimal::buffer res(2 * as.size(), temporary_resource());
+    Decimal::buffer scratch(Decimal::multiply_scratch(as.size(), as.size()), temporary_resource());
+    Decimal::multiply(res.data(), as.data(), as.size(), as.data(), as.size(), scratch.data());
+
+    return bigint_from_limbs(res);
+}
+
+// Long division of the base 10^9 limbs: schoolbook for short divisors, through a Newton
+// reciprocal built from multiply for long ones
+std::pair<bigint, bigint> divmod(bigint const & lhs, bigint const & rhs)
+{
+    return divmod(lhs, rhs, std::pmr::get_default_resource());
+}
+
+std::pair<bigint, bigint> divmod(bigint const & lhs, bigint const & rhs, std::pmr::memory_resource * upstream)
+{
+    alignas(std::max_align_t) std::array<std::byte, local_arena_size> local;
+    ArenaScope arena{local, divmod_arena_size(limb_count(lhs), limb_count(rhs)), upstream};
+
+    auto as = limbs_from_bigint(lhs);
+    auto bs = limbs_from_bigint(rhs);
+    while (!bs.empty() && bs.back() == 0)
+    {
+        bs.pop_back();
+    }
+
+    if (bs.empty())
+    {
+        throw std::invalid_argument("division by zero");
+    }
+
+    if (as.size() < bs.size())
+    {
+        return {{}, bigint_from_limbs(as)};
+    }
+
+    Decimal::buffer quotient(as.size() - bs.size() + 1, temporary_resource());
+    Decimal::buffer remainder(bs.size(), temporary_resource());
+    Decimal::divrem(quotient.data(), remainder.data(), as.data(), as.size(), bs.data(), bs.size());
+
+    return {bigint_from_limbs(quotient), bigint_from_limbs(remainder)};
+}
+
+bigint multiply(ThreadPool & pool, bigint const & lhs, bigint const & rhs)
+{
+    auto as = limbs_from_bigint(lhs);
+    auto bs = &lhs == &rhs ? Decimal::buffer{temporary_resource()} : limbs_from_bigint(rhs);
+    auto const * b = &lhs == &rhs ? &as : &bs;
+    auto const * a = &as;
+    if (a->size() < b->size())
+    {
+        std::swap(a, b);
+    }
+
+    if (b->empty())
+    {
+        return {};
+    }
+
+    Decimal::buffer res(a->size() + b->size(), temporary_resource());
+    Decimal::multiply(pool, res.data(), a->data(), a->size(), b->data(), b->size());
+
+    return bigint_from_limbs(res);
+}
+
+namespace
+{
+    // Products in one task of multiply_batch
+    constexpr size_t batch_grain = 64;
+
+    // Shorter operands below this many limbs are multiplied interleaved. Its schoolbook does
+    // one multiply-add per limb pair and carries once every 16 rows, which beats the scalar
+    // Karatsuba well past the 500 digits the batch is meant for.
+    constexpr size_t interleaved_cutoff = 64;
+
+    struct BatchItem
+    {
+        size_t index;
+        size_t an;
+        size_t bn;
+        bool swapped;
+    };
+
+    // Operands, products and scratch of the groups of one task, grown to the largest group
+    // and released when the task ends
+    struct BatchWorkspace
+    {
+        std::vector<uint64_t> lanes;
+        std::vector<limb> limbs;
+    };
+
+    // Products of items that all have the same lengths
+    void multiply_group(std::span<BatchItem const> items, std::span<bigint const> lhs, std::span<bigint const> rhs, std::span<bigint> out, BatchWorkspace & workspace)
+    {
+        size_t an = items.front().an;
+        size_t bn = items.front().bn;
+        auto operands = [&](BatchItem const & item)
+        {
+            return item.swapped ? std::pair{&rhs[item.index], &lhs[item.index]} : std::pair{&lhs[item.index], &rhs[item.index]};
+        };
+
+        if (bn == 0)
+        {
+            for (auto const & item : items)
+            {
+                out[item.index] = {};
+            }
+            return;
+        }
+
+        if (bn < interleaved_cutoff)
+        {
+            constexpr size_t lanes = interleaved_lanes;
+            auto & words = workspace.lanes;
+            words.resize(std::max(words.size(), 2 * (an + bn) * lanes));
+            uint64_t * a = words.data();
+            uint64_t * b = a + an * lanes;
+            uint64_t * r = b + bn * lanes;
+
+            for (size_t first = 0; first < items.size(); first += lanes)
+            {
+                size_t count = std::min(lanes, items.size() - first);
+                std::fill(a, r, uint64_t{0});
+                for (size_t l = 0; l < count; ++l)
+                {
+                    auto [x, y] = operands(items[first + l]);
+                    limbs_from_bigint(*x, a + l, lanes);
+                    limbs_from_bigint(*y, b + l, lanes);
+                }
+
+                multiply_interleaved(a, an, b, bn, r);
+
+                for (size_t l = 0; l < count; ++l)
+                {
+                    out[items[first + l].index] = bigint_from_limbs(r + l, an + bn, lanes);
+                }
+            }
+            return;
+        }
+
+        auto & limbs = workspace.limbs;
+        limbs.resize(std::max(limbs.size(), 2 * (an + bn) + Decimal::multiply_scratch(an, bn)));
+        limb * a = limbs.data();
+        limb * b = a + an;
+        limb * r = b + bn;
+        limb * scratch = r + an + bn;
+
+        for (auto const & item : items)
+        {
+            auto [x, y] = operands(item);
+            limbs_from_bigint(*x, a);
+            limbs_from_bigint(*y, b);
+            Decimal::multiply(r, a, an, b, bn, scratch);
+            out[item.index] = bigint_from_limbs(r, an + bn);
+        }
+    }
+
+    void multiply_batch(ThreadPool * pool, std::span<bigint const> lhs, std::span<bigint const> rhs, std::span<bigint> out)
+    {
+        if (lhs.size() != rhs.size() || lhs.size() != out.size())
+        {
+            throw std::invalid_argument("batch sizes differ");
+        }
+
+        std::vector<BatchItem> items(lhs.size());
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            size_t an = limb_count(lhs[i]);
+            size_t bn = limb_count(rhs[i]);
+            items[i] = {i, std::max(an, bn), std::min(an, bn), an < bn};
+        }
+        std::sort(items.begin(), items.end(), [](auto const & x, auto const & y) { return std::tie(x.an, x.bn) < std::tie(y.an, y.bn); });
+
+        // Runs of equal lengths, cut into tasks of at most batch_grain products
+        std::vector<std::span<BatchItem const>> groups;
+        for (size_t first = 0, last = 0; first < items.size(); first = last)
+        {
+            while (last < items.size() && items[last].an == items[first].an && items[last].bn == items[first].bn)
+            {
+                ++last;
+            }
+            for (size_t begin = first; begin < last; begin += batch_grain)
+            {
+                groups.emplace_back(items.data() + begin, std::min(batch_grain, last - begin));
+            }
+        }
+
+        auto run = [&](size_t first, size_t last)
+        {
+            BatchWorkspace workspace{};
+            for (size_t g = first; g < last; ++g)
+            {
+                multiply_group(groups[g], lhs, rhs, out, workspace);
+            }
+        };
+
+        if (pool)
         {
-            return {res};
+            parallel_for(*pool, 0, groups.size(), 1, run);
+        }
+        else
+        {
+            run(0, groups.size());
         }
-        return {static_cast<uint8_t>(res / 10), static_cast<uint8_t>(res % 10)};
     }
+}
 
-    size_t len = std::max(lhs.size(), rhs.size());
-    size_t n = len - (len / 2);
-    auto [a, b] = split(lhs, n);
-    auto [c, d] = split(rhs, n);
+void multiply_batch(std::span<bigint const> lhs, std::span<bigint const> rhs, std::span<bigint> out)
+{
+    multiply_batch(nullptr, lhs, rhs, out);
+}
 
-    auto ac = multiply(a, c);
-    auto bd = multiply(b, d);
-    auto ad_plus_bc = multiply(add(a, b), add(c, d));
-    ad_plus_bc = subtract(ad_plus_bc, ac);
-    ad_plus_bc = subtract(ad_plus_bc, bd);
+void multiply_batch(ThreadPool & pool, std::span<bigint const> lhs, std::span<bigint const> rhs, std::span<bigint> out)
+{
+    multiply_batch(&pool, lhs, rhs, out);
+}
 
-    auto res = power_ten(ac, 2 * n);
-    res = add(res, power_ten(ad_plus_bc, n));
-    res = add(res, bd);
+MultiplyThresholds & multiply_thresholds()
+{
+    return Decimal::thresholds;
+}
 
-    return res;
+MultiplyThresholds calibrate_multiply()
+{
+    return Decimal::calibrate();
 }
@@ -1,18 +1,87 @@
 #pragma once
 
+#include <compare>
 #include <cstdint>
+#include <memory_resource>
 #include <vector>
 #include <string>
 #include <optional>
+#include <span>
+#include <utility>
 
-using bigint = std::vector<uint8_t>;
+#include "multiply_thresholds.hpp"
+#include "small_vector.hpp"
+#include "thread_pool.hpp"
+
+// Decimal digits, most significant first; zero has no digits. Numbers of up to 40 digits
+// are stored inside the object.
+using bigint = SmallVector<uint8_t, 40>;
 
 bigint bigint_from_string(std::string const& str);
 
 std::string string_from_bigint(bigint const& n);
 
+// Numeric order in one scan from the top, leading zero digits ignored. The container order
+// of bigint is lexicographic and not numeric.
+std::strong_ordering compare(bigint const& lhs, bigint const& rhs);
+
 bigint add(bigint const& lhs, bigint const& rhs);
 
+// lhs must not be less than rhs, difference in signed_bigint.hpp takes either order
 bigint subtract(bigint const& lhs, bigint const& rhs);
 
-bigint multiply(bigint const& lhs, bigint const& rhs);
\ No newline at end of file
+// The overloads taking an rvalue write the result into its digits and reuse its capacity,
+// the larger one when both are rvalues
+bigint add(bigint&& lhs, bigint const& rhs);
+bigint add(bigint const& lhs, bigint&& rhs);
+bigint add(bigint&& lhs, bigint&& rhs);
+
+bigint subtract(bigint&& lhs, bigint const& rhs);
+bigint subtract(bigint const& lhs, bigint&& rhs);
+bigint subtract(bigint&& lhs, bigint&& rhs);
+
+// acc += x in place; it allocates only when acc outgrows its capacity
+void add_to(bigint& acc, bigint const& x);
+
+// acc -= x in place, acc must not be less than x
+void sub_from(bigint& acc, bigint const& x);
+
+// acc += x * 10^shift in place
+void add_shifted(bigint& acc, bigint const& x, size_t shift);
+
+// Aliased operands, as in multiply(x, x), are squared
+bigint multiply(bigint const& lhs, bigint const& rhs);
+
+bigint square(bigint const& n);
+
+// Quotient and remainder, throws std::invalid_argument when rhs is zero
+std::pair<bigint, bigint> divmod(bigint const& lhs, bigint const& rhs);
+
+// The same operations with their temporaries in an Arena over `upstream`, sized to the
+// operands and released in one step on return, so each call makes a constant number of
+// upstream allocations. The arena starts on the stack, which holds all temporaries of
+// operands of a few hundred digits. The overloads above use the default resource.
+bigint multiply(bigint const& lhs, bigint const& rhs, std::pmr::memory_resource* upstream);
+
+bigint square(bigint const& n, std::pmr::memory_resource* upstream);
+
+std::pair<bigint, bigint> divmod(bigint const& lhs, bigint const& rhs, std::pmr::memory_resource* upstream);
+
+// Same product, with the sub-products of large operands run as tasks on the pool
+bigint multiply(ThreadPool & pool, bigint const& lhs, bigint const& rhs);
+
+// out[i] = lhs[i] * rhs[i] for spans of equal size, throws std::invalid_argument otherwise.
+// The products are grouped by operand lengths. Groups with operands of up to a few hundred
+// digits are multiplied interleaved_lanes at a time, one vector instruction covering a
+// limb of several products; longer ones share one scratch area per task, released when the
+// call returns. out may be lhs or rhs itself but must not otherwise overlap them.
+void multiply_batch(std::span<bigint const> lhs, std::span<bigint const> rhs, std::span<bigint> out);
+
+// Same batch with the groups cut into tasks on the pool
+void multiply_batch(ThreadPool & pool, std::span<bigint const> lhs, std::span<bigint const> rhs, std::span<bigint> out);
+
+// Thresholds of multiply, in limbs of 9 digits. Changing them is not thread-safe.
+MultiplyThresholds & multiply_thresholds();
+
+// Times the algorithms on this machine and sets multiply_thresholds to the crossovers found
+MultiplyThresholds calibrate_multiply();
@@ -0,0 +1,119 @@
+#include "signed_bigint.hpp"
+
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    std::span<uint8_t const> significant(bigint const & n)
+    {
+        auto first = std::find_if(n.begin(), n.end(), [](uint8_t d) { return d != 0; });
+        return {first, n.end()};
+    }
+}
+
+SignedBigint::SignedBigint(bigint magnitude, bool negative) : digits(std::move(magnitude))
+{
+    digits.erase(digits.begin(), std::find_if(digits.begin(), digits.end(), [](uint8_t d) { return d != 0; }));
+    this->negative = negative && !digits.empty();
+}
+
+SignedBigint signed_bigint_from_string(std::string const & str)
+{
+    bool negative = !str.empty() && str.front() == '-';
+    if (negative && str.size() == 1)
+    {
+        throw std::invalid_argument("sign without digits");
+    }
+    return SignedBigint{bigint_from_string(negative ? str.substr(1) : str), negative};
+}
+
+std::string string_from_signed_bigint(SignedBigint const & n)
+{
+    auto digits = string_from_bigint(n.magnitude());
+    return n.is_negative() ? "-" + digits : digits;
+}
+
+SignedBigint difference(bigint const & lhs, bigint const & rhs)
+{
+    auto a = significant(lhs);
+    auto b = significant(rhs);
+
+    bool negative = a.size() < b.size();
+    if (a.size() == b.size())
+    {
+        auto [x, y] = std::mismatch(a.begin(), a.end(), b.begin());
+        if (x == a.end())
+        {
+            return {};
+        }
+
+        negative = *x < *y;
+        a = a.subspan(static_cast<size_t>(x - a.begin()));
+        b = b.subspan(static_cast<size_t>(y - b.begin()));
+    }
+
+    if (negative)
+    {
+        std::swap(a, b);
+    }
+
+    // The larger minus the smaller from the least significant digit
+    bigint res(a.size());
+    int borrow = 0;
+    for (size_t i = a.size(), j = b.size(); i-- > 0;)
+    {
+        int digit = a[i] - borrow - (j > 0 ? b[--j] : 0);
+        borrow = digit < 0;
+        res[i] = static_cast<uint8_t>(digit + 10 * borrow);
+    }
+
+    return SignedBigint{std::move(res), negative};
+}
+
+std::strong_ordering compare(SignedBigint const & lhs, SignedBigint const & rhs)
+{
+    if (lhs.is_negative() != rhs.is_negative())
+    {
+        return rhs.is_negative() <=> lhs.is_negative();
+    }
+
+    auto order = compare(lhs.magnitude(), rhs.magnitude());
+    return lhs.is_negative() ? 0 <=> order : order;
+}
+
+SignedBigint negate(SignedBigint n)
+{
+    n.negative = !n.negative && !n.digits.empty();
+    return n;
+}
+
+// Equal signs add the magnitudes, opposite ones take their difference
+SignedBigint add(SignedBigint const & lhs, SignedBigint const & rhs)
+{
+    if (lhs.is_negative() == rhs.is_negative())
+    {
+        return SignedBigint{add(lhs.magnitude(), rhs.magnitude()), lhs.is_negative()};
+    }
+
+    auto res = difference(lhs.magnitude(), rhs.magnitude());
+    return lhs.is_negative() ? negate(std::move(res)) : res;
+}
+
+SignedBigint subtract(SignedBigint const & lhs, SignedBigint const & rhs)
+{
+    if (lhs.is_negative() != rhs.is_negative())
+    {
+        return SignedBigint{add(lhs.magnitude(), rhs.magnitude()), lhs.is_negative()};
+    }
+
+    auto res = difference(lhs.magnitude(), rhs.magnitude());
+    return lhs.is_negative() ? negate(std::move(res)) : res;
+}
+
+SignedBigint multiply(SignedBigint const & lhs, SignedBigint const & rhs)
+{
+    return SignedBigint{multiply(lhs.magnitude(), rhs.magnitude()), lhs.is_negative() != rhs.is_negative()};
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <compare>
+#include <string>
+
+#include "product.hpp"
+
+// Integer with a sign over the decimal digits of a bigint, kept without leading zero digits;
+// zero has no digits and is never negative
+class SignedBigint
+{
+public:
+    SignedBigint() = default;
+    explicit SignedBigint(bigint magnitude, bool negative = false);
+
+    bigint const & magnitude() const { return digits; }
+    bool is_negative() const { return negative; }
+    bool is_zero() const { return digits.empty(); }
+
+    friend bool operator==(SignedBigint const &, SignedBigint const &) = default;
+    friend SignedBigint negate(SignedBigint n);
+
+private:
+    bigint digits{};
+    bool negative = false;
+};
+
+// An optional minus sign followed by digits
+SignedBigint signed_bigint_from_string(std::string const & str);
+
+std::string string_from_signed_bigint(SignedBigint const & n);
+
+// lhs - rhs for any two magnitudes. The scan for the first digit where they differ is the
+// comparison, the equal digits above it cancel, and only the ones below are subtracted, so
+// every digit is read once.
+SignedBigint difference(bigint const & lhs, bigint const & rhs);
+
+std::strong_ordering compare(SignedBigint const & lhs, SignedBigint const & rhs);
+
+inline std::strong_ordering operator<=>(SignedBigint const & lhs, SignedBigint const & rhs)
+{
+    return compare(lhs, rhs);
+}
+
+SignedBigint negate(SignedBigint n);
+
+SignedBigint add(SignedBigint const & lhs, SignedBigint const & rhs);
+
+SignedBigint subtract(SignedBigint const & lhs, SignedBigint const & rhs);
+
+SignedBigint multiply(SignedBigint const & lhs, SignedBigint const & rhs);
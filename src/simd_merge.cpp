@@ -0,0 +1,118 @@
+#include "simd_merge.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#include "simd_merge_kernel.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#    define SIMD_MERGE_X86 1
+
+uint64_t simd_merge_avx2(int32_t const * a, size_t a_size, int32_t const * b, size_t b_size, int32_t * out);
+uint64_t simd_merge_avx2(uint32_t const * a, size_t a_size, uint32_t const * b, size_t b_size, uint32_t * out);
+uint64_t simd_merge_avx2(int64_t const * a, size_t a_size, int64_t const * b, size_t b_size, int64_t * out);
+uint64_t simd_merge_avx2(float const * a, size_t a_size, float const * b, size_t b_size, float * out);
+uint64_t simd_merge_avx2(double const * a, size_t a_size, double const * b, size_t b_size, double * out);
+
+uint64_t simd_merge_avx512(int32_t const * a, size_t a_size, int32_t const * b, size_t b_size, int32_t * out);
+uint64_t simd_merge_avx512(uint32_t const * a, size_t a_size, uint32_t const * b, size_t b_size, uint32_t * out);
+uint64_t simd_merge_avx512(int64_t const * a, size_t a_size, int64_t const * b, size_t b_size, int64_t * out);
+uint64_t simd_merge_avx512(float const * a, size_t a_size, float const * b, size_t b_size, float * out);
+uint64_t simd_merge_avx512(double const * a, size_t a_size, double const * b, size_t b_size, double * out);
+#endif
+
+namespace
+{
+    SimdMergeKernel detect_kernel()
+    {
+#if defined(SIMD_MERGE_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt"))
+        {
+            return SimdMergeKernel::Avx512;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        {
+            return SimdMergeKernel::Avx2;
+        }
+#endif
+        return SimdMergeKernel::Scalar;
+    }
+
+    SimdMergeKernel const best_kernel = detect_kernel();
+    SimdMergeKernel current_kernel = best_kernel;
+
+    template <typename T>
+    uint64_t merge_counting_scalar(T const * a, size_t a_size, T const * b, size_t b_size, T * out)
+    {
+        uint64_t inversions = 0;
+        size_t i = 0;
+        size_t j = 0;
+        while (i < a_size && j < b_size)
+        {
+            bool take_b = b[j] < a[i];
+            *out++ = take_b ? b[j] : a[i];
+            inversions += take_b ? a_size - i : 0;
+            j += take_b;
+            i += !take_b;
+        }
+        merge_scalar(a + i, a_size - i, b + j, b_size - j, out);
+        return inversions;
+    }
+
+    template <typename T>
+    uint64_t dispatch(T const * a, size_t a_size, T const * b, size_t b_size, T * out)
+    {
+        switch (current_kernel)
+        {
+#if defined(SIMD_MERGE_X86)
+            case SimdMergeKernel::Avx512:
+                return simd_merge_avx512(a, a_size, b, b_size, out);
+            case SimdMergeKernel::Avx2:
+                return simd_merge_avx2(a, a_size, b, b_size, out);
+#endif
+            default:
+                return merge_counting_scalar(a, a_size, b, b_size, out);
+        }
+    }
+}
+
+uint64_t simd_merge(int32_t const * a, size_t a_size, int32_t const * b, size_t b_size, int32_t * out)
+{
+    return dispatch(a, a_size, b, b_size, out);
+}
+
+uint64_t simd_merge(uint32_t const * a, size_t a_size, uint32_t const * b, size_t b_size, uint32_t * out)
+{
+    return dispatch(a, a_size, b, b_size, out);
+}
+
+uint64_t simd_merge(int64_t const * a, size_t a_size, int64_t const * b, size_t b_size, int64_t * out)
+{
+    return dispatch(a, a_size, b, b_size, out);
+}
+
+uint64_t simd_merge(float const * a, size_t a_size, float const * b, size_t b_size, float * out)
+{
+    return dispatch(a, a_size, b, b_size, out);
+}
+
+uint64_t simd_merge(double const * a, size_t a_size, double const * b, size_t b_size, double * out)
+{
+    return dispatch(a, a_size, b, b_size, out);
+}
+
+// The kernels are ordered, and a CPU that runs one also runs those before it
+bool simd_merge_supports(SimdMergeKernel kernel)
+{
+    return kernel <= best_kernel;
+}
+
+SimdMergeKernel use_simd_merge_kernel(SimdMergeKernel kernel)
+{
+    if (!simd_merge_supports(kernel))
+    {
+        throw std::invalid_argument("kernel not supported");
+    }
+    return std::exchange(current_kernel, kernel);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized merge of two sorted arrays for arithmetic keys ordered by the built-in `<`.
+// Uses AVX-512 or AVX2 bitonic merge networks when the CPU has them and a branchless
+// scalar loop otherwise. Returns the number of pairs (x, y), x in a and y in b, with y < x,
+// which is what merge() counts. The output must not overlap the inputs.
+//
+// The output is a permutation of the inputs, every value is copied bit for bit. Equal keys
+// are interchangeable, so the order they come out in does not matter; the only exception is
+// +0.0 and -0.0, whose relative order is unspecified. A NaN is kept, but the keys around it
+// are no longer sorted.
+
+template <typename T>
+concept simd_mergeable = std::same_as<T, int32_t> || std::same_as<T, uint32_t> || std::same_as<T, int64_t> || std::same_as<T, float>
+    || std::same_as<T, double>;
+
+uint64_t simd_merge(int32_t const * a, size_t a_size, int32_t const * b, size_t b_size, int32_t * out);
+
+uint64_t simd_merge(uint32_t const * a, size_t a_size, uint32_t const * b, size_t b_size, uint32_t * out);
+
+uint64_t simd_merge(int64_t const * a, size_t a_size, int64_t const * b, size_t b_size, int64_t * out);
+
+uint64_t simd_merge(float const * a, size_t a_size, float const * b, size_t b_size, float * out);
+
+uint64_t simd_merge(double const * a, size_t a_size, double const * b, size_t b_size, double * out);
+
+// Kernels of simd_merge, from the scalar loop to the widest vectors
+enum class SimdMergeKernel
+{
+    Scalar,
+    Avx2,
+    Avx512,
+};
+
+// Whether this CPU can run the kernel
+bool simd_merge_supports(SimdMergeKernel kernel);
+
+// Makes simd_merge run the given kernel and returns the one it ran before, throws
+// std::invalid_argument if the CPU does not support it. It is meant for tests that check
+// every kernel; changing it is not thread-safe.
+SimdMergeKernel use_simd_merge_kernel(SimdMergeKernel kernel);
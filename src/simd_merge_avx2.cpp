@@ -0,0 +1,206 @@
+// Compiled with -mavx2 -mpopcnt, only called after the CPU has been checked
+
+#include "simd_merge_kernel.hpp"
+
+#if defined(__AVX2__)
+
+#    include <immintrin.h>
+
+namespace
+{
+    template <int D>
+    constexpr int lane_mask(int lanes, int bits_per_lane)
+    {
+        int mask = 0;
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            if (lane & D)
+            {
+                mask |= ((1 << bits_per_lane) - 1) << (lane * bits_per_lane);
+            }
+        }
+        return mask;
+    }
+
+    template <int D>
+    constexpr int xor_shuffle_4x64()
+    {
+        int imm = 0;
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            imm |= (lane ^ D) << (lane * 2);
+        }
+        return imm;
+    }
+
+    template <int D>
+    __m256i xor_index_8x32()
+    {
+        return _mm256_setr_epi32(0 ^ D, 1 ^ D, 2 ^ D, 3 ^ D, 4 ^ D, 5 ^ D, 6 ^ D, 7 ^ D);
+    }
+
+    struct Int32Ops
+    {
+        using T = int32_t;
+        using V = __m256i;
+        static constexpr size_t width = 8;
+
+        static V load(T const * p) { return _mm256_loadu_si256(reinterpret_cast<V const *>(p)); }
+        static void store(T * p, V v) { _mm256_storeu_si256(reinterpret_cast<V *>(p), v); }
+        static V min(V a, V b) { return _mm256_min_epi32(a, b); }
+        static V max(V a, V b) { return _mm256_max_epi32(a, b); }
+        static V reverse(V v) { return _mm256_permutevar8x32_epi32(v, xor_index_8x32<7>()); }
+
+        template <int D>
+        static V sort_step(V v)
+        {
+            V other = _mm256_permutevar8x32_epi32(v, xor_index_8x32<D>());
+            return _mm256_blend_epi32(min(v, other), max(v, other), lane_mask<D>(8, 1));
+        }
+
+        static size_t count_greater(V v, T x)
+        {
+            V greater = _mm256_cmpgt_epi32(v, _mm256_set1_epi32(x));
+            return _mm_popcnt_u32(_mm256_movemask_ps(_mm256_castsi256_ps(greater)));
+        }
+    };
+
+    struct UInt32Ops
+    {
+        using T = uint32_t;
+        using V = __m256i;
+        static constexpr size_t width = 8;
+
+        static V load(T const * p) { return _mm256_loadu_si256(reinterpret_cast<V const *>(p)); }
+        static void store(T * p, V v) { _mm256_storeu_si256(reinterpret_cast<V *>(p), v); }
+        static V min(V a, V b) { return _mm256_min_epu32(a, b); }
+        static V max(V a, V b) { return _mm256_max_epu32(a, b); }
+        static V reverse(V v) { return _mm256_permutevar8x32_epi32(v, xor_index_8x32<7>()); }
+
+        template <int D>
+        static V sort_step(V v)
+        {
+            V other = _mm256_permutevar8x32_epi32(v, xor_index_8x32<D>());
+            return _mm256_blend_epi32(min(v, other), max(v, other), lane_mask<D>(8, 1));
+        }
+
+        static size_t count_greater(V v, T x)
+        {
+            // No unsigned compare in AVX2, flipping the sign bit maps it onto the signed one
+            V bias = _mm256_set1_epi32(static_cast<int>(0x80000000U));
+            V greater = _mm256_cmpgt_epi32(_mm256_xor_si256(v, bias), _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(x)), bias));
+            return _mm_popcnt_u32(_mm256_movemask_ps(_mm256_castsi256_ps(greater)));
+        }
+    };
+
+    struct FloatOps
+    {
+        using T = float;
+        using V = __m256;
+        static constexpr size_t width = 8;
+
+        static V load(T const * p) { return _mm256_loadu_ps(p); }
+        static void store(T * p, V v) { _mm256_storeu_ps(p, v); }
+        // Blends on one comparison instead of min and max, which return their second operand
+        // for +0.0 and -0.0 or a NaN and so would lose one of the two values
+        static V min(V a, V b) { return _mm256_blendv_ps(a, b, _mm256_cmp_ps(b, a, _CMP_LT_OQ)); }
+        static V max(V a, V b) { return _mm256_blendv_ps(b, a, _mm256_cmp_ps(b, a, _CMP_LT_OQ)); }
+        static V reverse(V v) { return _mm256_permutevar8x32_ps(v, xor_index_8x32<7>()); }
+
+        // Both lanes of a pair swap when the upper one is below the lower one
+        template <int D>
+        static V sort_step(V v)
+        {
+            V other = _mm256_permutevar8x32_ps(v, xor_index_8x32<D>());
+            V swap = _mm256_blend_ps(_mm256_cmp_ps(other, v, _CMP_LT_OQ), _mm256_cmp_ps(v, other, _CMP_LT_OQ), lane_mask<D>(8, 1));
+            return _mm256_blendv_ps(v, other, swap);
+        }
+
+        static size_t count_greater(V v, T x)
+        {
+            V greater = _mm256_cmp_ps(v, _mm256_set1_ps(x), _CMP_GT_OQ);
+            return _mm_popcnt_u32(_mm256_movemask_ps(greater));
+        }
+    };
+
+    struct Int64Ops
+    {
+        using T = int64_t;
+        using V = __m256i;
+        static constexpr size_t width = 4;
+
+        static V load(T const * p) { return _mm256_loadu_si256(reinterpret_cast<V const *>(p)); }
+        static void store(T * p, V v) { _mm256_storeu_si256(reinterpret_cast<V *>(p), v); }
+        static V min(V a, V b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+        static V max(V a, V b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+        static V reverse(V v) { return _mm256_permute4x64_epi64(v, xor_shuffle_4x64<3>()); }
+
+        template <int D>
+        static V sort_step(V v)
+        {
+            V other = _mm256_permute4x64_epi64(v, xor_shuffle_4x64<D>());
+            return _mm256_blend_epi32(min(v, other), max(v, other), lane_mask<D>(4, 2));
+        }
+
+        static size_t count_greater(V v, T x)
+        {
+            V greater = _mm256_cmpgt_epi64(v, _mm256_set1_epi64x(x));
+            return _mm_popcnt_u32(_mm256_movemask_pd(_mm256_castsi256_pd(greater)));
+        }
+    };
+
+    struct DoubleOps
+    {
+        using T = double;
+        using V = __m256d;
+        static constexpr size_t width = 4;
+
+        static V load(T const * p) { return _mm256_loadu_pd(p); }
+        static void store(T * p, V v) { _mm256_storeu_pd(p, v); }
+        // Exact like FloatOps
+        static V min(V a, V b) { return _mm256_blendv_pd(a, b, _mm256_cmp_pd(b, a, _CMP_LT_OQ)); }
+        static V max(V a, V b) { return _mm256_blendv_pd(b, a, _mm256_cmp_pd(b, a, _CMP_LT_OQ)); }
+        static V reverse(V v) { return _mm256_permute4x64_pd(v, xor_shuffle_4x64<3>()); }
+
+        template <int D>
+        static V sort_step(V v)
+        {
+            V other = _mm256_permute4x64_pd(v, xor_shuffle_4x64<D>());
+            V swap = _mm256_blend_pd(_mm256_cmp_pd(other, v, _CMP_LT_OQ), _mm256_cmp_pd(v, other, _CMP_LT_OQ), lane_mask<D>(4, 1));
+            return _mm256_blendv_pd(v, other, swap);
+        }
+
+        static size_t count_greater(V v, T x)
+        {
+            V greater = _mm256_cmp_pd(v, _mm256_set1_pd(x), _CMP_GT_OQ);
+            return _mm_popcnt_u32(_mm256_movemask_pd(greater));
+        }
+    };
+}
+
+uint64_t simd_merge_avx2(int32_t const * a, size_t a_size, int32_t const * b, size_t b_size, int32_t * out)
+{
+    return merge_kernel<Int32Ops>(a, a_size, b, b_size, out);
+}
+
+uint64_t simd_merge_avx2(uint32_t const * a, size_t a_size, uint32_t const * b, size_t b_size, uint32_t * out)
+{
+    return merge_kernel<UInt32Ops>(a, a_size, b, b_size, out);
+}
+
+uint64_t simd_merge_avx2(int64_t const * a, size_t a_size, int64_t const * b, size_t b_size, int64_t * out)
+{
+    return merge_kernel<Int64Ops>(a, a_size, b, b_size, out);
+}
+
+uint64_t simd_merge_avx2(float const * a, size_t a_size, float const * b, size_t b_size, float * out)
+{
+    return merge_kernel<FloatOps>(a, a_size, b, b_size, out);
+}
+
+uint64_t simd_merge_avx2(double const * a, size_t a_size, double const * b, size_t b_size, double * out)
+{
+    return merge_kernel<DoubleOps>(a, a_size, b, b_size, out);
+}
+
+#endif
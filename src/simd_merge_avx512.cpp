@@ -0,0 +1,184 @@
+// Compiled with -mavx512f -mpopcnt, only called after the CPU has been checked
+
+#include "simd_merge_kernel.hpp"
+
+#if defined(__AVX512F__)
+
+#    include <immintrin.h>
+
+namespace
+{
+    template <int D>
+    constexpr unsigned lane_mask(int lanes)
+    {
+        unsigned mask = 0;
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            if (lane & D)
+            {
+                mask |= 1U << lane;
+            }
+        }
+        return mask;
+    }
+
+    template <int D>
+    __m512i xor_index_16x32()
+    {
+        return _mm512_setr_epi32(0 ^ D, 1 ^ D, 2 ^ D, 3 ^ D, 4 ^ D, 5 ^ D, 6 ^ D, 7 ^ D, 8 ^ D, 9 ^ D, 10 ^ D, 11 ^ D, 12 ^ D, 13 ^ D, 14 ^ D, 15 ^ D);
+    }
+
+    template <int D>
+    __m512i xor_index_8x64()
+    {
+        return _mm512_setr_epi64(0 ^ D, 1 ^ D, 2 ^ D, 3 ^ D, 4 ^ D, 5 ^ D, 6 ^ D, 7 ^ D);
+    }
+
+    struct Int32Ops
+    {
+        using T = int32_t;
+        using V = __m512i;
+        static constexpr size_t width = 16;
+
+        static V load(T const * p) { return _mm512_loadu_si512(p); }
+        static void store(T * p, V v) { _mm512_storeu_si512(p, v); }
+        static V min(V a, V b) { return _mm512_min_epi32(a, b); }
+        static V max(V a, V b) { return _mm512_max_epi32(a, b); }
+        static V reverse(V v) { return _mm512_permutexvar_epi32(xor_index_16x32<15>(), v); }
+
+        template <int D>
+        static V sort_step(V v)
+        {
+            V other = _mm512_permutexvar_epi32(xor_index_16x32<D>(), v);
+            return _mm512_mask_blend_epi32(lane_mask<D>(16), min(v, other), max(v, other));
+        }
+
+        static size_t count_greater(V v, T x) { return _mm_popcnt_u32(_mm512_cmpgt_epi32_mask(v, _mm512_set1_epi32(x))); }
+    };
+
+    struct UInt32Ops
+    {
+        using T = uint32_t;
+        using V = __m512i;
+        static constexpr size_t width = 16;
+
+        static V load(T const * p) { return _mm512_loadu_si512(p); }
+        static void store(T * p, V v) { _mm512_storeu_si512(p, v); }
+        static V min(V a, V b) { return _mm512_min_epu32(a, b); }
+        static V max(V a, V b) { return _mm512_max_epu32(a, b); }
+        static V reverse(V v) { return _mm512_permutexvar_epi32(xor_index_16x32<15>(), v); }
+
+        template <int D>
+        static V sort_step(V v)
+        {
+            V other = _mm512_permutexvar_epi32(xor_index_16x32<D>(), v);
+            return _mm512_mask_blend_epi32(lane_mask<D>(16), min(v, other), max(v, other));
+        }
+
+        static size_t count_greater(V v, T x)
+        {
+            return _mm_popcnt_u32(_mm512_cmpgt_epu32_mask(v, _mm512_set1_epi32(static_cast<int>(x))));
+        }
+    };
+
+    struct FloatOps
+    {
+        using T = float;
+        using V = __m512;
+        static constexpr size_t width = 16;
+
+        static V load(T const * p) { return _mm512_loadu_ps(p); }
+        static void store(T * p, V v) { _mm512_storeu_ps(p, v); }
+        // Blends on one comparison instead of min and max, which return their second operand
+        // for +0.0 and -0.0 or a NaN and so would lose one of the two values
+        static V min(V a, V b) { return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(b, a, _CMP_LT_OQ), a, b); }
+        static V max(V a, V b) { return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(b, a, _CMP_LT_OQ), b, a); }
+        static V reverse(V v) { return _mm512_permutexvar_ps(xor_index_16x32<15>(), v); }
+
+        // Both lanes of a pair swap when the upper one is below the lower one
+        template <int D>
+        static V sort_step(V v)
+        {
+            V other = _mm512_permutexvar_ps(xor_index_16x32<D>(), v);
+            __mmask16 upper = lane_mask<D>(16);
+            __mmask16 swap = (_mm512_cmp_ps_mask(other, v, _CMP_LT_OQ) & ~upper) | (_mm512_cmp_ps_mask(v, other, _CMP_LT_OQ) & upper);
+            return _mm512_mask_blend_ps(swap, v, other);
+        }
+
+        static size_t count_greater(V v, T x) { return _mm_popcnt_u32(_mm512_cmp_ps_mask(v, _mm512_set1_ps(x), _CMP_GT_OQ)); }
+    };
+
+    struct Int64Ops
+    {
+        using T = int64_t;
+        using V = __m512i;
+        static constexpr size_t width = 8;
+
+        static V load(T const * p) { return _mm512_loadu_si512(p); }
+        static void store(T * p, V v) { _mm512_storeu_si512(p, v); }
+        static V min(V a, V b) { return _mm512_min_epi64(a, b); }
+        static V max(V a, V b) { return _mm512_max_epi64(a, b); }
+        static V reverse(V v) { return _mm512_permutexvar_epi64(xor_index_8x64<7>(), v); }
+
+        template <int D>
+        static V sort_step(V v)
+        {
+            V other = _mm512_permutexvar_epi64(xor_index_8x64<D>(), v);
+            return _mm512_mask_blend_epi64(lane_mask<D>(8), min(v, other), max(v, other));
+        }
+
+        static size_t count_greater(V v, T x) { return _mm_popcnt_u32(_mm512_cmpgt_epi64_mask(v, _mm512_set1_epi64(x))); }
+    };
+
+    struct DoubleOps
+    {
+        using T = double;
+        using V = __m512d;
+        static constexpr size_t width = 8;
+
+        static V load(T const * p) { return _mm512_loadu_pd(p); }
+        static void store(T * p, V v) { _mm512_storeu_pd(p, v); }
+        // Exact like FloatOps
+        static V min(V a, V b) { return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(b, a, _CMP_LT_OQ), a, b); }
+        static V max(V a, V b) { return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(b, a, _CMP_LT_OQ), b, a); }
+        static V reverse(V v) { return _mm512_permutexvar_pd(xor_index_8x64<7>(), v); }
+
+        template <int D>
+        static V sort_step(V v)
+        {
+            V other = _mm512_permutexvar_pd(xor_index_8x64<D>(), v);
+            __mmask8 upper = lane_mask<D>(8);
+            __mmask8 swap = (_mm512_cmp_pd_mask(other, v, _CMP_LT_OQ) & ~upper) | (_mm512_cmp_pd_mask(v, other, _CMP_LT_OQ) & upper);
+            return _mm512_mask_blend_pd(swap, v, other);
+        }
+
+        static size_t count_greater(V v, T x) { return _mm_popcnt_u32(_mm512_cmp_pd_mask(v, _mm512_set1_pd(x), _CMP_GT_OQ)); }
+    };
+}
+
+uint64_t simd_merge_avx512(int32_t const * a, size_t a_size, int32_t const * b, size_t b_size, int32_t * out)
+{
+    return merge_kernel<Int32Ops>(a, a_size, b, b_size, out);
+}
+
+uint64_t simd_merge_avx512(uint32_t const * a, size_t a_size, uint32_t const * b, size_t b_size, uint32_t * out)
+{
+    return merge_kernel<UInt32Ops>(a, a_size, b, b_size, out);
+}
+
+uint64_t simd_merge_avx512(int64_t const * a, size_t a_size, int64_t const * b, size_t b_size, int64_t * out)
+{
+    return merge_kernel<Int64Ops>(a, a_size, b, b_size, out);
+}
+
+uint64_t simd_merge_avx512(float const * a, size_t a_size, float const * b, size_t b_size, float * out)
+{
+    return merge_kernel<FloatOps>(a, a_size, b, b_size, out);
+}
+
+uint64_t simd_merge_avx512(double const * a, size_t a_size, double const * b, size_t b_size, double * out)
+{
+    return merge_kernel<DoubleOps>(a, a_size, b, b_size, out);
+}
+
+#endif
@@ -0,0 +1,171 @@
+#pragma once
+
+// Bitonic merge kernel shared by the per-ISA translation units. Everything here has internal
+// linkage on purpose: each unit compiles its own copy for its own instruction set, and the
+// linker must not pick one of them for code running on another CPU. Standard library
+// templates are kept out of the kernels for the same reason.
+//
+// Ops provides for one vector type V of `width` lanes of T:
+//   load, store, min, max (between them returning each of their operands once, also for keys
+//     that compare equal or unordered), reverse,
+//   sort_step<D> (compare-exchange of lanes i and i ^ D, the larger one going to the lane with bit D set,
+//     the two values kept as they are),
+//   count_greater(v, x) (number of lanes of v greater than x).
+
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+
+template <typename T>
+void merge_scalar(T const * a, size_t a_size, T const * b, size_t b_size, T * out)
+{
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a_size && j < b_size)
+    {
+        bool take_b = b[j] < a[i];
+        *out++ = take_b ? b[j] : a[i];
+        j += take_b;
+        i += !take_b;
+    }
+    for (; i < a_size; ++i)
+    {
+        *out++ = a[i];
+    }
+    for (; j < b_size; ++j)
+    {
+        *out++ = b[j];
+    }
+}
+
+template <typename Ops, size_t D>
+typename Ops::V sort_bitonic(typename Ops::V v)
+{
+    v = Ops::template sort_step<D>(v);
+    if constexpr (D > 1)
+    {
+        v = sort_bitonic<Ops, D / 2>(v);
+    }
+    return v;
+}
+
+// Sorted lo and hi become the lower and the upper half of their union, both sorted
+template <typename Ops>
+void bitonic_merge(typename Ops::V & lo, typename Ops::V & hi)
+{
+    auto reversed = Ops::reverse(hi);
+    auto l = Ops::min(lo, reversed);
+    auto h = Ops::max(lo, reversed);
+    lo = sort_bitonic<Ops, Ops::width / 2>(l);
+    hi = sort_bitonic<Ops, Ops::width / 2>(h);
+}
+
+// Number of pairs (x, y), x in a and y in b, with y < x. a is taken a vector at a time and
+// every element of b below the vector's last lane is compared against all lanes at once,
+// the popcount of the mask is its share; elements of b before that window are below every lane.
+template <typename Ops>
+uint64_t count_cross_inversions(typename Ops::T const * a, size_t a_size, typename Ops::T const * b, size_t b_size)
+{
+    constexpr size_t width = Ops::width;
+
+    uint64_t inversions = 0;
+    size_t i = 0;
+    size_t j = 0;
+    for (; i + width <= a_size; i += width)
+    {
+        auto block = Ops::load(a + i);
+        auto last = a[i + width - 1];
+
+        inversions += width * j;
+        for (; j < b_size && b[j] < last; ++j)
+        {
+            inversions += Ops::count_greater(block, b[j]);
+        }
+    }
+
+    for (; i < a_size; ++i)
+    {
+        for (; j < b_size && b[j] < a[i]; ++j)
+        {
+        }
+        inversions += j;
+    }
+
+    return inversions;
+}
+
+template <typename Ops>
+void merge_vectors(typename Ops::T const * a, size_t a_size, typename Ops::T const * b, size_t b_size, typename Ops::T * out)
+{
+    using T = typename Ops::T;
+    constexpr size_t width = Ops::width;
+
+    if (a_size < width || b_size < width)
+    {
+        merge_scalar(a, a_size, b, b_size, out);
+        return;
+    }
+
+    auto lo = Ops::load(a);
+    auto hi = Ops::load(b);
+    size_t i = width;
+    size_t j = width;
+
+    // hi keeps the largest `width` elements seen so far, the next vector comes from the
+    // input with the smaller head, as long as that input still has a whole vector
+    bool from_a = false;
+    while (true)
+    {
+        bitonic_merge<Ops>(lo, hi);
+        Ops::store(out, lo);
+        out += width;
+
+        from_a = j == b_size || (i < a_size && !(b[j] < a[i]));
+        if (from_a)
+        {
+            if (i + width > a_size)
+            {
+                break;
+            }
+            lo = Ops::load(a + i);
+            i += width;
+        }
+        else
+        {
+            if (j + width > b_size)
+            {
+                break;
+            }
+            lo = Ops::load(b + j);
+            j += width;
+        }
+    }
+
+    // Merge hi with the short tail of the input that stopped the loop, then with the other one
+    T top[width];
+    T merged[width * 2];
+    Ops::store(top, hi);
+
+    if (from_a)
+    {
+        merge_scalar(top, width, a + i, a_size - i, merged);
+        merge_scalar(merged, width + (a_size - i), b + j, b_size - j, out);
+    }
+    else
+    {
+        merge_scalar(top, width, b + j, b_size - j, merged);
+        merge_scalar(merged, width + (b_size - j), a + i, a_size - i, out);
+    }
+}
+
+template <typename Ops>
+uint64_t merge_kernel(typename Ops::T const * a, size_t a_size, typename Ops::T const * b, size_t b_size, typename Ops::T * out)
+{
+    uint64_t inversions = count_cross_inversions<Ops>(a, a_size, b, b_size);
+    merge_vectors<Ops>(a, a_size, b, b_size, out);
+    return inversions;
+}
+
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+// Contiguous sequence of trivially copyable values with room for N of them inside the
+// object. It goes to the heap only when it grows past N and then keeps its heap buffer,
+// like the capacity of a vector. Moving steals a heap buffer and copies inline values, so
+// pointers into a short sequence do not survive a move.
+template <typename T, size_t N>
+class SmallVector
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = T &;
+    using const_reference = T const &;
+    using pointer = T *;
+    using const_pointer = T const *;
+    using iterator = T *;
+    using const_iterator = T const *;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static constexpr size_t inline_capacity = N;
+
+    SmallVector() = default;
+    explicit SmallVector(size_t count) : SmallVector(count, T{}) {}
+    SmallVector(size_t count, T const & value) { assign(count, value); }
+    SmallVector(std::initializer_list<T> init) { assign(init.begin(), init.end()); }
+
+    template <std::input_iterator It>
+    SmallVector(It first, It last)
+    {
+        assign(first, last);
+    }
+
+    SmallVector(SmallVector const & other) { assign(other.begin(), other.end()); }
+    SmallVector(SmallVector && other) noexcept { take(other); }
+    ~SmallVector() { release(); }
+
+    SmallVector & operator=(SmallVector const & other)
+    {
+        if (this != &other)
+        {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    SmallVector & operator=(SmallVector && other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    SmallVector & operator=(std::initializer_list<T> init)
+    {
+        assign(init.begin(), init.end());
+        return *this;
+    }
+
+    void assign(size_t count, T const & value)
+    {
+        T copy = value;
+        clear();
+        resize(count, copy);
+    }
+
+    template <std::input_iterator It>
+    void assign(It first, It last)
+    {
+        clear();
+        if constexpr (std::forward_iterator<It>)
+        {
+            size_t count = static_cast<size_t>(std::distance(first, last));
+            reserve(count);
+            std::copy(first, last, values);
+            length = count;
+        }
+        else
+        {
+            for (; first != last; ++first)
+            {
+                push_back(*first);
+            }
+        }
+    }
+
+    T * data() { return values; }
+    T const * data() const { return values; }
+    size_t size() const { return length; }
+    size_t capacity() const { return room; }
+    bool empty() const { return length == 0; }
+
+    // Whether the values are stored inside the object
+    bool is_inline() const { return values == local; }
+
+    T & operator[](size_t i) { return values[i]; }
+    T const & operator[](size_t i) const { return values[i]; }
+    T & front() { return values[0]; }
+    T const & front() const { return values[0]; }
+    T & back() { return values[length - 1]; }
+    T const & back() const { return values[length - 1]; }
+
+    iterator begin() { return values; }
+    iterator end() { return values + length; }
+    const_iterator begin() const { return values; }
+    const_iterator end() const { return values + length; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    reverse_iterator rbegin() { return reverse_iterator{end()}; }
+    reverse_iterator rend() { return reverse_iterator{begin()}; }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator{end()}; }
+    const_reverse_iterator rend() const { return const_reverse_iterator{begin()}; }
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator crend() const { return rend(); }
+
+    void reserve(size_t capacity)
+    {
+        if (capacity > room)
+        {
+            reallocate(capacity);
+        }
+    }
+
+    void resize(size_t count) { resize(count, T{}); }
+
+    void resize(size_t count, T const & value)
+    {
+        if (count > length)
+        {
+            T copy = value;
+            reserve(grown(count));
+            std::fill(values + length, values + count, copy);
+        }
+        length = count;
+    }
+
+    // Like resize, but the values past the old size are left for the caller to write
+    void resize_for_overwrite(size_t count)
+    {
+        reserve(grown(count));
+        length = count;
+    }
+
+    void clear() { length = 0; }
+
+    void push_back(T const & value)
+    {
+        T copy = value;
+        reserve(grown(length + 1));
+        values[length++] = copy;
+    }
+
+    void pop_back() { --length; }
+
+    iterator insert(const_iterator pos, T const & value) { return insert(pos, 1, value); }
+
+    iterator insert(const_iterator pos, size_t count, T const & value)
+    {
+        size_t index = static_cast<size_t>(pos - values);
+        T copy = value;
+        reserve(grown(length + count));
+        std::memmove(values + index + count, values + index, (length - index) * sizeof(T));
+        std::fill(values + index, values + index + count, copy);
+        length += count;
+        return values + index;
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_t index = static_cast<size_t>(first - values);
+        size_t count = static_cast<size_t>(last - first);
+        std::memmove(values + index, values + index + count, (length - index - count) * sizeof(T));
+        length -= count;
+        return values + index;
+    }
+
+    void swap(SmallVector & other) noexcept
+    {
+        SmallVector temp = std::move(other);
+        other = std::move(*this);
+        *this = std::move(temp);
+    }
+
+    friend bool operator==(SmallVector const & lhs, SmallVector const & rhs)
+    {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+    friend auto operator<=>(SmallVector const & lhs, SmallVector const & rhs)
+    {
+        return std::lexicographical_compare_three_way(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+private:
+    // Capacity for count values, doubling so that repeated growth stays amortized
+    size_t grown(size_t count) const
+    {
+        return count <= room ? room : std::max(count, 2 * room);
+    }
+
+    void reallocate(size_t capacity)
+    {
+        T * next = std::allocator<T>{}.allocate(capacity);
+        std::memcpy(next, values, length * sizeof(T));
+        size_t count = length;
+        release();
+        values = next;
+        room = capacity;
+        length = count;
+    }
+
+    void release()
+    {
+        if (!is_inline())
+        {
+            std::allocator<T>{}.deallocate(values, room);
+        }
+        values = local;
+        room = N;
+        length = 0;
+    }
+
+    void take(SmallVector & other)
+    {
+        if (other.is_inline())
+        {
+            std::memcpy(local, other.local, other.length * sizeof(T));
+        }
+        else
+        {
+            values = other.values;
+            room = other.room;
+            other.values = other.local;
+            other.room = N;
+        }
+        length = other.length;
+        other.length = 0;
+    }
+
+    T * values = local;
+    size_t length = 0;
+    size_t room = N;
+    T local[N];
+};
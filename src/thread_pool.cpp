@@ -0,0 +1,159 @@
+#include "thread_pool.hpp"
+
+#include <utility>
+
+namespace
+{
+    thread_local ThreadPool const * current_pool = nullptr;
+    thread_local size_t current_index = 0;
+}
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    threads = std::max<size_t>(threads, 1);
+
+    queues.reserve(threads);
+    for (size_t i = 0; i < threads; ++i)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i)
+    {
+        workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock{sleep_mutex};
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto & worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    // Workers push to their own deque, everybody else spreads the tasks round-robin
+    size_t index = current_pool == this ? current_index : next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+    {
+        std::lock_guard lock{sleep_mutex};
+        pending.fetch_add(1, std::memory_order_release);
+    }
+
+    {
+        std::lock_guard lock{queues[index]->mutex};
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::runPendingTask()
+{
+    std::function<void()> task{};
+
+    size_t index = current_pool == this ? current_index : next_queue.load(std::memory_order_relaxed) % queues.size();
+    if (!tryPop(index, task) && !trySteal(index, task))
+    {
+        return false;
+    }
+
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+    current_pool = this;
+    current_index = index;
+
+    std::function<void()> task{};
+    while (true)
+    {
+        if (tryPop(index, task) || trySteal(index, task))
+        {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock lock{sleep_mutex};
+        wake.wait(lock, [this]() { return stopping || pending.load(std::memory_order_acquire) > 0; });
+        if (stopping && pending.load(std::memory_order_acquire) == 0)
+        {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::tryPop(size_t index, std::function<void()> & task)
+{
+    auto & queue = *queues[index];
+    std::lock_guard lock{queue.mutex};
+    if (queue.tasks.empty())
+    {
+        return false;
+    }
+
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    pending.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+bool ThreadPool::trySteal(size_t index, std::function<void()> & task)
+{
+    for (size_t i = 1; i < queues.size(); ++i)
+    {
+        auto & queue = *queues[(index + i) % queues.size()];
+        std::lock_guard lock{queue.mutex};
+        if (queue.tasks.empty())
+        {
+            continue;
+        }
+
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        pending.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    return false;
+}
+
+TaskGroup::~TaskGroup()
+{
+    // Tasks reference the group, so it must not go away before they are done
+    while (outstanding.load(std::memory_order_acquire) > 0)
+    {
+        if (!pool.runPendingTask())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void TaskGroup::wait()
+{
+    while (outstanding.load(std::memory_order_acquire) > 0)
+    {
+        if (!pool.runPendingTask())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    std::lock_guard lock{error_mutex};
+    if (error)
+    {
+        std::rethrow_exception(std::exchange(error, nullptr));
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool: every worker owns a deque, pops its own tasks LIFO and steals
+// the oldest tasks of the other workers when it runs dry.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool & operator=(ThreadPool const &) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    void submit(std::function<void()> task);
+
+    // Runs one queued task on the calling thread, returns false if there was none.
+    // Lets a waiting thread help instead of blocking, which keeps nested tasks deadlock-free.
+    bool runPendingTask();
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void workerLoop(size_t index);
+    bool tryPop(size_t index, std::function<void()> & task);
+    bool trySteal(size_t index, std::function<void()> & task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> next_queue{0};
+    bool stopping{false};
+};
+
+// Set of tasks that can be waited on together. The first exception thrown by a task
+// is rethrown from wait().
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool & pool) : pool(pool) { }
+    ~TaskGroup();
+
+    TaskGroup(TaskGroup const &) = delete;
+    TaskGroup & operator=(TaskGroup const &) = delete;
+
+    template <typename Func>
+    void run(Func && func)
+    {
+        outstanding.fetch_add(1, std::memory_order_relaxed);
+        pool.submit(
+            [this, func = std::forward<Func>(func)]() mutable
+            {
+                try
+                {
+                    func();
+                }
+                catch (...)
+                {
+                    std::lock_guard lock{error_mutex};
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+                outstanding.fetch_sub(1, std::memory_order_release);
+            });
+    }
+
+    void wait();
+
+private:
+    ThreadPool & pool;
+    std::atomic<size_t> outstanding{0};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+};
+
+// Calls func(first, last) for consecutive chunks of [begin, end) of at least `grain` indices.
+template <typename Func>
+void parallel_for(ThreadPool & pool, size_t begin, size_t end, size_t grain, Func func)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    grain = std::max<size_t>(grain, 1);
+    if (end - begin <= grain)
+    {
+        func(begin, end);
+        return;
+    }
+
+    TaskGroup group{pool};
+    for (size_t first = begin; first < end; first += grain)
+    {
+        size_t last = std::min(first + grain, end);
+        group.run([&func, first, last]() { func(first, last); });
+    }
+    group.wait();
+}
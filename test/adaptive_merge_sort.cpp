@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/adaptive_merge_sort.hpp"
+#include "../src/merge_sort.hpp"
+
+TEST_CASE("Adaptive sort of runs")
+{
+    size_t inversions{};
+    REQUIRE(adaptive_merge_sort(std::vector<int>{}, inversions).empty());
+    REQUIRE(adaptive_merge_sort(std::vector<int>{1, 3, 5, 2, 4, 6}, inversions) == std::vector<int>{1, 2, 3, 4, 5, 6});
+    REQUIRE(inversions == 3);
+
+    std::vector<int> descending(1000);
+    std::iota(descending.rbegin(), descending.rend(), 0);
+    adaptive_merge_sort(descending, inversions);
+    REQUIRE(inversions == 1000 * 999 / 2);
+
+    // Equal elements stop a descending run, they are not inversions
+    REQUIRE(adaptive_merge_sort(std::vector<int>{3, 2, 2, 1}, inversions) == std::vector<int>{1, 2, 2, 3});
+    REQUIRE(inversions == 5);
+}
+
+TEST_CASE("Adaptive sort matches merge_sort")
+{
+    std::random_device random_device{};
+    std::mt19937 mt_19937{random_device()};
+    std::uniform_int_distribution<int> generator{0, 3000};
+
+    for (int i = 0; i < 300; ++i)
+    {
+        std::vector<std::pair<int, int>> xs(generator(mt_19937));
+        for (size_t j = 0; j < xs.size(); ++j)
+        {
+            xs[j] = {generator(mt_19937) % 50, static_cast<int>(j)};
+        }
+
+        // Mostly sorted input with a few late arrivals, and some reversed stretches
+        if (i % 3 != 0)
+        {
+            std::stable_sort(xs.begin(), xs.end(), [](auto const & a, auto const & b) { return a.first < b.first; });
+            for (int k = 0; k < 5 && !xs.empty(); ++k)
+            {
+                std::swap(xs[generator(mt_19937) % xs.size()], xs[generator(mt_19937) % xs.size()]);
+            }
+        }
+        if (i % 3 == 2 && xs.size() > 100)
+        {
+            std::reverse(xs.begin() + 10, xs.begin() + 90);
+        }
+
+        auto comp = [](auto const & a, auto const & b) { return a.first < b.first; };
+
+        size_t expected_inversions{};
+        auto expected = merge_sort(xs, comp, expected_inversions);
+
+        size_t inversions{};
+        REQUIRE(adaptive_merge_sort(xs, comp, inversions) == expected);
+        REQUIRE(inversions == expected_inversions);
+    }
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/bigint_expression.hpp"
+#include "../src/product.hpp"
+#include "random_bigint.hpp"
+
+namespace
+{
+    bigint from(std::string const & str)
+    {
+        return bigint_from_string(str);
+    }
+
+    // x * 10^digits the slow way
+    bigint shifted(bigint x, size_t digits)
+    {
+        if (!x.empty())
+        {
+            x.insert(x.end(), digits, 0);
+        }
+        return x;
+    }
+}
+
+TEST_CASE("Expressions of a few digits")
+{
+    auto a = from("123");
+    auto b = from("989");
+    auto c = from("7");
+
+    REQUIRE(bigint(a + b) == from("1112"));
+    REQUIRE(bigint(b - a) == from("866"));
+    REQUIRE(bigint(a * b) == from("121647"));
+    REQUIRE(bigint(a << 3) == from("123000"));
+    REQUIRE(bigint((a << 2) + b) == from("13289"));
+    REQUIRE(bigint(a + b << 1) == from("11120"));
+    REQUIRE(bigint(b - (a << 1) + (c << 3)) == from("6759"));
+
+    // Only the final result must be non-negative
+    REQUIRE(bigint(a - b + b) == a);
+    REQUIRE(bigint(c - a - b + (a << 1) + b) == from("1114"));
+    REQUIRE(bigint(a - a).empty());
+    REQUIRE_THROWS_AS(bigint(a - b), std::invalid_argument);
+
+    // Carries of many positive terms, zero and leading zeros
+    auto nines = from("999");
+    REQUIRE(bigint(nines + nines + nines + nines + nines + nines + nines + nines + nines + nines + nines + nines) == from("11988"));
+    REQUIRE(bigint(bigint{} + a) == a);
+    REQUIRE(bigint(bigint{0, 0, 4} + bigint{0, 5}) == bigint{9});
+    REQUIRE(bigint(bigint{} << 5).empty());
+    REQUIRE(bigint(a * bigint{}).empty());
+
+    // Products enter sums as one term, and rvalue operands are held by the expression
+    REQUIRE(bigint(a * b + (c << 2) - a * c) == from("121486"));
+    REQUIRE(bigint(from("5") * from("6") + from("12")) == from("42"));
+    REQUIRE(bigint((a + b) * (b - a)) == from("962992"));
+    REQUIRE(bigint(a * b * c) == from("851529"));
+    REQUIRE(bigint(a * a) == multiply(a, a));
+}
+
+TEST_CASE("Expressions evaluate into a destination")
+{
+    auto a = from("4567");
+    auto b = from("321");
+
+    auto const e = (a << 4) + b - bigint{1};
+    REQUIRE(bigint(e) == from("45670320"));
+    a = from("1");
+    REQUIRE(bigint(e) == from("10320"));
+
+    // The destination keeps its buffer and may be an operand
+    bigint dest(100, 5);
+    auto const * buffer = dest.data();
+    evaluate(dest, (b << 60) + b);
+    REQUIRE(dest.data() == buffer);
+    REQUIRE(dest == add(shifted(b, 60), b));
+
+    evaluate(dest, dest + (dest << 1) - b);
+    REQUIRE(dest == add(shifted(add(shifted(b, 60), b), 1), shifted(b, 60)));
+
+    bigint x = from("12");
+    evaluate(x, x * x + x);
+    REQUIRE(x == from("156"));
+
+    // A negative result leaves the destination alone
+    bigint y = from("987654321");
+    REQUIRE_THROWS_AS(evaluate(y, (b << 20) + x - (b << 20) - (x << 1)), std::invalid_argument);
+    REQUIRE(y == from("987654321"));
+    REQUIRE_THROWS_AS(evaluate(x, b - x - x - x), std::invalid_argument);
+    REQUIRE(x == from("156"));
+}
+
+TEST_CASE("Fused sums match chained add and subtract")
+{
+    std::mt19937 mt_19937{25};
+    std::uniform_int_distribution<size_t> length{0, 300};
+
+    for (int i = 0; i < 200; ++i)
+    {
+        auto a = random_bigint(mt_19937, length(mt_19937));
+        auto b = random_bigint(mt_19937, length(mt_19937));
+        auto c = random_bigint(mt_19937, length(mt_19937));
+        size_t n = length(mt_19937);
+
+        // The recombination of a Karatsuba step
+        auto expected = add(add(shifted(a, 2 * n), shifted(b, n)), c);
+        REQUIRE(bigint((a << 2 * n) + (b << n) + c) == expected);
+        REQUIRE(bigint((a << 2 * n) + (b << n) + c - (b << n)) == add(shifted(a, 2 * n), c));
+        REQUIRE(bigint(c + (a << 2 * n) - c) == shifted(a, 2 * n));
+
+        // Shifts within a group of the pass
+        size_t s = n % 8;
+        size_t t = n % 13;
+        REQUIRE(bigint((a << s) + (b << t) + (c << 1) - (a << s) + (b << 9) - (b << t)) == add(shifted(b, 9), shifted(c, 1)));
+
+        auto const & big = compare(a, b) < 0 ? b : a;
+        auto const & small = compare(a, b) < 0 ? a : b;
+        REQUIRE(bigint(big - small) == subtract(big, small));
+        if (compare(a, b) != 0)
+        {
+            REQUIRE_THROWS_AS(bigint(small - big + (c << n) - (c << n)), std::invalid_argument);
+        }
+        REQUIRE(bigint(a * b + c) == add(multiply(a, b), c));
+        if (!a.empty())
+        {
+            REQUIRE(bigint((a * b << n) - (b << n)) == shifted(subtract(multiply(a, b), b), n));
+        }
+    }
+}
@@ -0,0 +1,286 @@
+#include <random>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/bignum.hpp"
+#include "../src/product.hpp"
+
+namespace
+{
+    std::string random_digits(std::mt19937 & mt_19937, size_t size)
+    {
+        std::uniform_int_distribution<int> digit{0, 9};
+        std::string res(size, '0');
+        for (auto & c : res)
+        {
+            c = char('0' + digit(mt_19937));
+        }
+        if (size > 0 && res.front() == '0')
+        {
+            res.front() = '1';
+        }
+        return res;
+    }
+
+    // Quadratic product straight from the definition
+    BigNum schoolbook(BigNum const & a, BigNum const & b)
+    {
+        std::vector<uint64_t> res(a.size() + b.size());
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            uint64_t carry = 0;
+            for (size_t j = 0; j < b.size(); ++j)
+            {
+                unsigned __int128 product = (unsigned __int128) a.limbs()[i] * b.limbs()[j] + res[i + j] + carry;
+                res[i + j] = uint64_t(product);
+                carry = uint64_t(product >> 64);
+            }
+            res[i + b.size()] = carry;
+        }
+        return BigNum{res};
+    }
+}
+
+TEST_CASE("BigNum decimal conversions")
+{
+    REQUIRE(bignum_from_string("").is_zero());
+    REQUIRE(bignum_from_string("000").is_zero());
+    REQUIRE(string_from_bignum(BigNum{}).empty());
+    REQUIRE(string_from_bignum(bignum_from_string("000")) == string_from_bigint(bigint{}));
+    REQUIRE(bigint_from_bignum(BigNum{}).empty());
+
+    REQUIRE(bignum_from_string("18446744073709551615") == BigNum{UINT64_MAX});
+    REQUIRE(bignum_from_string("18446744073709551616") == BigNum{std::vector<uint64_t>{0, 1}});
+    REQUIRE(string_from_bignum(BigNum{std::vector<uint64_t>{0, 1, 0, 0}}) == "18446744073709551616");
+    REQUIRE(string_from_bignum(bignum_from_string("0010000000000000000000")) == "10000000000000000000");
+
+    REQUIRE(bigint_from_bignum(bignum_from_bigint({0, 4, 2})) == bigint{4, 2});
+
+    REQUIRE_THROWS_AS(bignum_from_string("12a"), std::invalid_argument);
+    REQUIRE_THROWS_AS(bignum_from_bigint({10}), std::invalid_argument);
+
+    std::mt19937 mt_19937{42};
+    for (size_t size : {1, 18, 19, 20, 38, 39, 40, 500})
+    {
+        auto digits = random_digits(mt_19937, size);
+        REQUIRE(string_from_bignum(bignum_from_string(digits)) == digits);
+    }
+}
+
+TEST_CASE("BigNum add, subtract and compare")
+{
+    auto max = BigNum{UINT64_MAX};
+    auto two_limbs = BigNum{std::vector<uint64_t>{0, 1}};
+
+    REQUIRE(add(max, BigNum{1}) == two_limbs);
+    REQUIRE(subtract(two_limbs, BigNum{1}) == max);
+    REQUIRE(subtract(two_limbs, two_limbs).is_zero());
+    REQUIRE(add(BigNum{}, max) == max);
+
+    REQUIRE(max < two_limbs);
+    REQUIRE(BigNum{} < BigNum{1});
+    REQUIRE(compare(two_limbs, two_limbs) == std::strong_ordering::equal);
+    REQUIRE(BigNum{std::vector<uint64_t>{5, 1}} > BigNum{std::vector<uint64_t>{7, 0}});
+
+    std::mt19937 mt_19937{7};
+    for (int i = 0; i < 50; ++i)
+    {
+        auto a = random_digits(mt_19937, 1 + mt_19937() % 300);
+        auto b = random_digits(mt_19937, 1 + mt_19937() % 300);
+
+        auto sum = add(bignum_from_string(a), bignum_from_string(b));
+        REQUIRE(bigint_from_bignum(sum) == add(bigint_from_string(a), bigint_from_string(b)));
+        REQUIRE(subtract(sum, bignum_from_string(b)) == bignum_from_string(a));
+    }
+}
+
+TEST_CASE("BigNum multiply")
+{
+    REQUIRE(multiply(BigNum{}, BigNum{5}).is_zero());
+    REQUIRE(multiply(BigNum{UINT64_MAX}, BigNum{UINT64_MAX}) == BigNum{std::vector<uint64_t>{1, UINT64_MAX - 1}});
+
+    auto a = bignum_from_string("3141592653589793238462643383279502884197169399375105820974944592");
+    auto b = bignum_from_string("2718281828459045235360287471352662497757247093699959574966967627");
+    REQUIRE(string_from_bignum(multiply(a, b)) == "8539734222673567065463550869546574495034888535765114961879601127"
+                                                  "067743044893204848617875072216249073013374895871952806582723184");
+
+    // All limbs at their maximum push every carry to the end
+    auto ones = BigNum{std::vector<uint64_t>(100, UINT64_MAX)};
+    REQUIRE(multiply(ones, ones) == schoolbook(ones, ones));
+
+    // Sizes on both sides of the Karatsuba threshold, balanced and not
+    std::mt19937 mt_19937{1};
+    for (auto [a_size, b_size] : {std::pair{100, 100}, {700, 650}, {1300, 1300}, {3000, 700}, {2500, 1900}, {4000, 20}})
+    {
+        auto x = random_digits(mt_19937, a_size);
+        auto y = random_digits(mt_19937, b_size);
+
+        auto a = bignum_from_string(x);
+        auto b = bignum_from_string(y);
+
+        auto expected = schoolbook(a, b);
+        REQUIRE(multiply(a, b) == expected);
+        REQUIRE(multiply(b, a) == expected);
+        REQUIRE(string_from_bignum(multiply(a, bignum_from_string("1" + std::string(b_size, '0')))) == x + std::string(b_size, '0'));
+    }
+}
+
+TEST_CASE("BigNum multiply through Toom-Cook and the transform")
+{
+    std::mt19937_64 mt_19937{9};
+
+    auto saved = bignum_multiply_thresholds();
+    bignum_multiply_thresholds() = {24, 100, 300, 1000, SIZE_MAX};
+
+    for (auto [a_size, b_size] : {std::pair{250, 250}, {700, 690}, {1100, 1100}, {3000, 1500}})
+    {
+        std::vector<uint64_t> x(a_size);
+        std::vector<uint64_t> y(b_size);
+        std::generate(x.begin(), x.end(), mt_19937);
+        std::generate(y.begin(), y.end(), mt_19937);
+
+        auto a = BigNum{x};
+        auto b = BigNum{y};
+        REQUIRE(multiply(a, b) == schoolbook(a, b));
+    }
+
+    for (size_t size : {400, 1200})
+    {
+        auto ones = BigNum{std::vector<uint64_t>(size, UINT64_MAX)};
+        REQUIRE(multiply(ones, ones) == schoolbook(ones, ones));
+    }
+
+    bignum_multiply_thresholds() = saved;
+}
+
+TEST_CASE("BigNum multiply on a thread pool")
+{
+    std::mt19937_64 mt_19937{13};
+
+    ThreadPool pool{3};
+    auto saved = bignum_multiply_thresholds();
+    bignum_multiply_thresholds().parallel = 30;
+
+    for (auto [a_size, b_size] : {std::pair{500, 500}, {777, 400}, {1500, 90}})
+    {
+        std::vector<uint64_t> x(a_size);
+        std::vector<uint64_t> y(b_size);
+        std::generate(x.begin(), x.end(), mt_19937);
+        std::generate(y.begin(), y.end(), mt_19937);
+
+        auto a = BigNum{x};
+        auto b = BigNum{y};
+        REQUIRE(multiply(pool, a, b) == schoolbook(a, b));
+    }
+
+    auto ones = BigNum{std::vector<uint64_t>(700, UINT64_MAX)};
+    REQUIRE(multiply(pool, ones, ones) == schoolbook(ones, ones));
+
+    bignum_multiply_thresholds() = saved;
+}
+
+TEST_CASE("BigNum square")
+{
+    std::mt19937_64 mt_19937{16};
+
+    REQUIRE(square(BigNum{}).is_zero());
+    REQUIRE(square(BigNum{UINT64_MAX}) == BigNum{std::vector<uint64_t>{1, UINT64_MAX - 1}});
+
+    auto saved = bignum_multiply_thresholds();
+
+    for (auto const & tier : {saved, MultiplyThresholds{8, 40, 120, 400, 100}})
+    {
+        bignum_multiply_thresholds() = tier;
+
+        for (size_t size : {3, 30, 333, 1000})
+        {
+            std::vector<uint64_t> x(size);
+            std::generate(x.begin(), x.end(), mt_19937);
+
+            auto a = BigNum{x};
+            auto ones = BigNum{std::vector<uint64_t>(size, UINT64_MAX)};
+            REQUIRE(square(a) == schoolbook(a, a));
+            REQUIRE(square(ones) == schoolbook(ones, ones));
+        }
+    }
+
+    ThreadPool pool{2};
+    auto a = BigNum{std::vector<uint64_t>(600, 0x0123456789abcdef)};
+    REQUIRE(multiply(pool, a, a) == schoolbook(a, a));
+
+    bignum_multiply_thresholds() = saved;
+}
+
+TEST_CASE("BigNum decimal conversions of large numbers")
+{
+    std::mt19937 mt_19937{17};
+
+    // Powers of ten and their neighbours on both sides of every split point
+    for (size_t zeros : {607, 608, 609, 1215, 1216, 4000})
+    {
+        auto power = bignum_from_string("1" + std::string(zeros, '0'));
+        auto expected = BigNum{1};
+        for (size_t i = 0; i < zeros; ++i)
+        {
+            expected = multiply(expected, BigNum{10});
+        }
+        REQUIRE(power == expected);
+        REQUIRE(string_from_bignum(subtract(power, BigNum{1})) == std::string(zeros, '9'));
+    }
+
+    // Limbs that are all ones print as 2^(64 n) - 1
+    auto ones = BigNum{std::vector<uint64_t>(300, UINT64_MAX)};
+    auto two_power = BigNum{1};
+    for (size_t i = 0; i < 300 * 64; ++i)
+    {
+        two_power = add(two_power, two_power);
+    }
+    REQUIRE(add(ones, BigNum{1}) == two_power);
+    REQUIRE(bignum_from_string(string_from_bignum(ones)) == ones);
+
+    for (size_t size : {700, 5000, 60000})
+    {
+        auto x = random_digits(mt_19937, size);
+        auto y = random_digits(mt_19937, size / 3);
+        REQUIRE(string_from_bignum(bignum_from_string(x)) == x);
+
+        // The digit multiply never leaves base ten, so it checks both conversions
+        auto product = multiply(bignum_from_string(x), bignum_from_string(y));
+        REQUIRE(bigint_from_bignum(product) == multiply(bigint_from_string(x), bigint_from_string(y)));
+    }
+
+    REQUIRE(bignum_from_string("000" + std::string(3000, '0')).is_zero());
+    REQUIRE_THROWS_AS(bignum_from_string(std::string(5000, '1') + "/"), std::invalid_argument);
+    REQUIRE_THROWS_AS(bignum_from_string(std::string(5000, '1') + ":"), std::invalid_argument);
+}
+
+TEST_CASE("BigNum divmod")
+{
+    std::mt19937_64 mt_19937{20};
+
+    auto random_bignum = [&](size_t size, uint64_t top)
+    {
+        std::vector<uint64_t> x(size);
+        std::generate(x.begin(), x.end(), mt_19937);
+        x.back() = top;
+        return BigNum{x};
+    };
+
+    REQUIRE(divmod(BigNum{7}, BigNum{2}) == std::pair{BigNum{3}, BigNum{1}});
+    REQUIRE(divmod(BigNum{2}, BigNum{7}) == std::pair{BigNum{}, BigNum{2}});
+    REQUIRE_THROWS_AS(divmod(BigNum{1}, BigNum{}), std::invalid_argument);
+
+    // Small top limbs need the most normalization, all-ones limbs none
+    for (auto [q_size, b_size] : {std::pair{1, 1}, {50, 1}, {30, 2}, {200, 40}, {1300, 1200}, {100, 2500}})
+    {
+        for (auto const & b : {random_bignum(b_size, mt_19937() | 1), random_bignum(b_size, 5), BigNum{std::vector<uint64_t>(b_size, UINT64_MAX)}})
+        {
+            auto q = random_bignum(q_size, mt_19937() | 1);
+            auto r = subtract(b, BigNum{1});
+            auto a = add(multiply(q, b), r);
+
+            REQUIRE(divmod(a, b) == std::pair{q, r});
+            REQUIRE(divmod(subtract(a, r), b) == std::pair{q, BigNum{}});
+        }
+    }
+}
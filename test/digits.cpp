@@ -0,0 +1,79 @@
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/digits.hpp"
+
+TEST_CASE("Digit conversions check every byte")
+{
+    std::mt19937 mt_19937{18};
+    std::uniform_int_distribution<int> digit{0, 9};
+
+    // Lengths around the vector widths, with a bad byte at every position and of every value
+    for (size_t size : {0, 1, 15, 16, 17, 31, 32, 33, 64, 100})
+    {
+        std::string chars(size, '0');
+        std::vector<uint8_t> digits(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            digits[i] = static_cast<uint8_t>(digit(mt_19937));
+            chars[i] = static_cast<char>('0' + digits[i]);
+        }
+
+        std::vector<uint8_t> parsed(size);
+        std::string printed(size, '\0');
+        REQUIRE(digits_from_chars(chars.data(), size, parsed.data()));
+        REQUIRE(chars_from_digits(digits.data(), size, printed.data()));
+        REQUIRE(parsed == digits);
+        REQUIRE(printed == chars);
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            for (int value = 0; value < 256; ++value)
+            {
+                auto bad_chars = chars;
+                bad_chars[i] = static_cast<char>(value);
+                REQUIRE(digits_from_chars(bad_chars.data(), size, parsed.data()) == (value >= '0' && value <= '9'));
+
+                auto bad_digits = digits;
+                bad_digits[i] = static_cast<uint8_t>(value);
+                REQUIRE(chars_from_digits(bad_digits.data(), size, printed.data()) == (value <= 9));
+            }
+        }
+    }
+}
+
+TEST_CASE("Packing digits into a limb")
+{
+    std::vector<uint8_t> digits{9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+    REQUIRE(pack_eight_digits(digits.data()) == 98765432);
+    REQUIRE(pack_digits(digits.data(), 0) == 0);
+    REQUIRE(pack_digits(digits.data(), 3) == 987);
+    REQUIRE(pack_digits(digits.data(), 16) == 9876543210123456);
+    REQUIRE(pack_digits(digits.data(), 19) == 9876543210123456789ull);
+
+    std::vector<uint8_t> nines(19, 9);
+    REQUIRE(pack_digits(nines.data(), 19) == 9999999999999999999ull);
+}
+
+TEST_CASE("Unpacking a limb into digits")
+{
+    std::vector<uint8_t> digits(8);
+
+    unpack_eight_digits(98765432, digits.data());
+    REQUIRE(digits == std::vector<uint8_t>{9, 8, 7, 6, 5, 4, 3, 2});
+    unpack_eight_digits(0, digits.data());
+    REQUIRE(digits == std::vector<uint8_t>(8, 0));
+    unpack_eight_digits(99999999, digits.data());
+    REQUIRE(digits == std::vector<uint8_t>(8, 9));
+
+    std::mt19937 mt_19937{25};
+    for (int i = 0; i < 10000; ++i)
+    {
+        uint64_t value = mt_19937() % 100'000'000;
+        unpack_eight_digits(value, digits.data());
+        REQUIRE(pack_eight_digits(digits.data()) == value);
+    }
+}
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/external_sort.hpp"
+
+std::vector<int64_t> read_numbers(std::string const & path)
+{
+    std::ifstream file{path};
+    std::vector<int64_t> res{};
+    int64_t value{};
+    while (file >> value)
+    {
+        res.push_back(value);
+    }
+    return res;
+}
+
+TEST_CASE("External sort of assigment 3.5")
+{
+    std::string input = "../test/data/problem3.5.txt";
+    auto output = (std::filesystem::temp_directory_path() / "external_sort_problem3.5.txt").string();
+
+    auto expected = read_numbers(input);
+    REQUIRE(expected.size() == 100000);
+    std::sort(expected.begin(), expected.end());
+
+    // Chunks of 4096 numbers make 25 runs merged at once
+    REQUIRE(external_sort(input, output, {.memory_limit = 64 << 10, .min_run_buffer = 1 << 10}) == 2407905288);
+    REQUIRE(read_numbers(output) == expected);
+
+    // Chunks of 1024 numbers and a fan-in of 3 take several merge rounds
+    REQUIRE(external_sort(input, output, {.memory_limit = 16 << 10, .min_run_buffer = 4 << 10}) == 2407905288);
+    REQUIRE(read_numbers(output) == expected);
+
+    std::filesystem::remove(output);
+}
+
+TEST_CASE("External sort of small inputs")
+{
+    auto dir = std::filesystem::temp_directory_path();
+    auto input = (dir / "external_sort_small_in.txt").string();
+    auto output = (dir / "external_sort_small_out.txt").string();
+
+    std::ofstream{input} << "";
+    REQUIRE(external_sort(input, output) == 0);
+    REQUIRE(read_numbers(output).empty());
+
+    std::ofstream{input} << "3\n-1 2\r\n\n-9000000000\n3";
+    REQUIRE(external_sort(input, output, {.memory_limit = 32}) == 5);
+    REQUIRE(read_numbers(output) == std::vector<int64_t>{-9000000000, -1, 2, 3, 3});
+
+    std::ofstream{input} << "1\n2x\n";
+    REQUIRE_THROWS_AS(external_sort(input, output), std::invalid_argument);
+
+    // A write that fails only once the file is closed
+    if (std::filesystem::exists("/dev/full"))
+    {
+        std::ofstream{input} << "3\n1\n2\n";
+        REQUIRE_THROWS_AS(external_sort(input, "/dev/full"), std::runtime_error);
+    }
+
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+}
@@ -0,0 +1,71 @@
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/inversion_counter.hpp"
+#include "../src/merge_sort.hpp"
+
+TEST_CASE("Streaming inversion counter")
+{
+    InversionCounter<int> counter{};
+    REQUIRE(counter.inversions() == 0);
+
+    for (int x : {3, 1, 2, 2, 0})
+    {
+        counter.push(x);
+    }
+    REQUIRE(counter.size() == 5);
+    REQUIRE(counter.inversions() == 7);
+
+    counter.pop();
+    REQUIRE(counter.oldest() == 1);
+    REQUIRE(counter.inversions() == 3);
+
+    while (!counter.empty())
+    {
+        counter.pop();
+    }
+    REQUIRE(counter.inversions() == 0);
+}
+
+TEST_CASE("Sliding window matches merge_sort on the same window")
+{
+    std::random_device random_device{};
+    std::mt19937 mt_19937{random_device()};
+    std::uniform_int_distribution<int> generator{0, 100};
+
+    for (size_t window_size : {1, 2, 17, 200})
+    {
+        InversionCounter<int> counter{window_size};
+        std::vector<int> feed{};
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            feed.push_back(generator(mt_19937));
+            counter.push(feed.back());
+
+            size_t first = feed.size() > window_size ? feed.size() - window_size : 0;
+            std::vector<int> window{feed.begin() + first, feed.end()};
+
+            size_t expected{};
+            merge_sort(window, expected);
+            REQUIRE(counter.size() == window.size());
+            REQUIRE(counter.inversions() == expected);
+        }
+    }
+}
+
+TEST_CASE("Streaming counter with a custom order")
+{
+    auto by_length = [](std::string const & a, std::string const & b) { return a.size() < b.size(); };
+    InversionCounter<std::string, decltype(by_length)> counter{3, by_length};
+
+    for (std::string word : {"ccc", "a", "bb", "dd", "e"})
+    {
+        counter.push(word);
+    }
+
+    // Window is bb, dd, e
+    REQUIRE(counter.inversions() == 2);
+}
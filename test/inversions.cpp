@@ -0,0 +1,76 @@
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/inversions.hpp"
+
+TEST_CASE("Count inversions")
+{
+    REQUIRE(count_inversions(std::vector<int>{}) == 0);
+    REQUIRE(count_inversions(std::vector<int>{1}) == 0);
+    REQUIRE(count_inversions(std::vector<int>{1, 3, 5, 2, 4, 6}) == 3);
+    REQUIRE(count_inversions(std::vector<int>{6, 5, 4, 3, 2, 1}) == 15);
+    REQUIRE(count_inversions(std::vector<int>{2, 2, 1, 1}) == 4);
+
+    REQUIRE(count_inversions(std::vector<int>{6, 5, 4, 3, 2, 1}, [](int a, int b) { return a > b; }) == 0);
+}
+
+TEST_CASE("Inversion counts do not overflow 32 bits in a single merge")
+{
+    std::vector<int> xs(100000);
+    std::iota(xs.rbegin(), xs.rend(), 0);
+
+    uint64_t expected = uint64_t{100000} * 99999 / 2;
+
+    REQUIRE(count_inversions(xs) == expected);
+    REQUIRE(count_inversions<WideCounter>(xs) == expected);
+
+    size_t inversions{};
+    merge_sort(xs, inversions);
+    REQUIRE(inversions == expected);
+
+    ThreadPool pool{4};
+    REQUIRE(count_inversions(pool, xs) == expected);
+}
+
+TEST_CASE("Count inversions matches merge_sort")
+{
+    ThreadPool pool{3};
+
+    std::random_device random_device{};
+    std::mt19937 mt_19937{random_device()};
+    std::uniform_int_distribution<int> generator{0, 500};
+
+    for (int i = 0; i < 300; ++i)
+    {
+        std::vector<int> xs(generator(mt_19937) * 3);
+        std::generate(xs.begin(), xs.end(), [&]() { return generator(mt_19937); });
+
+        size_t expected{};
+        merge_sort(xs, expected);
+
+        REQUIRE(count_inversions(xs) == expected);
+        REQUIRE(count_inversions<WideCounter>(xs) == expected);
+        REQUIRE(count_inversions(pool, xs) == expected);
+    }
+}
+
+TEST_CASE("Count inversions of assigment 3.5")
+{
+    std::ifstream data_file{"../test/data/problem3.5.txt"};
+    REQUIRE(data_file.is_open());
+
+    std::vector<int> nums{};
+    std::string line{};
+    while (std::getline(data_file, line))
+    {
+        nums.push_back(std::stoi(line));
+    }
+
+    ThreadPool pool{4};
+
+    REQUIRE(count_inversions(nums) == 2407905288);
+    REQUIRE(count_inversions(pool, nums) == 2407905288);
+}
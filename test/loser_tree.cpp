@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/loser_tree.hpp"
+#include "../src/merge_sort.hpp"
+
+TEST_CASE("K-way merge")
+{
+    using Range = std::pair<std::vector<int>::const_iterator, std::vector<int>::const_iterator>;
+
+    std::vector<int> a{1, 4, 7};
+    std::vector<int> b{2, 5};
+    std::vector<int> c{0, 3, 6, 9};
+
+    std::vector<int> merged{};
+    std::vector<Range> ranges{{a.cbegin(), a.cend()}, {b.cbegin(), b.cend()}, {c.cbegin(), c.cend()}};
+    auto inversions = kway_merge(ranges, std::back_inserter(merged), std::less<>{});
+
+    REQUIRE(merged == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 9});
+    REQUIRE(std::all_of(ranges.begin(), ranges.end(), [](Range const & r) { return r.first == r.second; }));
+
+    std::vector<int> concatenated{1, 4, 7, 2, 5, 0, 3, 6, 9};
+    size_t expected{};
+    merge_sort(concatenated, expected);
+    REQUIRE(inversions == expected);
+
+    merged.clear();
+    ranges.clear();
+    REQUIRE(kway_merge(ranges, std::back_inserter(merged), std::less<>{}) == 0);
+    REQUIRE(merged.empty());
+}
+
+TEST_CASE("K-way merge is stable")
+{
+    using Item = std::pair<int, int>;
+    using Range = std::pair<std::vector<Item>::const_iterator, std::vector<Item>::const_iterator>;
+
+    std::vector<std::vector<Item>> inputs{{{1, 0}, {2, 0}}, {{1, 1}, {1, 1}, {2, 1}}, {}, {{0, 3}, {2, 3}}};
+    std::vector<Range> ranges{};
+    for (auto const & input : inputs)
+    {
+        ranges.emplace_back(input.cbegin(), input.cend());
+    }
+
+    std::vector<Item> merged{};
+    kway_merge(ranges, std::back_inserter(merged), [](Item const & x, Item const & y) { return x.first < y.first; });
+
+    REQUIRE(merged == std::vector<Item>{{0, 3}, {1, 0}, {1, 1}, {1, 1}, {2, 0}, {2, 1}, {2, 3}});
+}
+
+TEST_CASE("K-way merge sort matches merge_sort")
+{
+    std::random_device random_device{};
+    std::mt19937 mt_19937{random_device()};
+    std::uniform_int_distribution<int> generator{0, 1000};
+
+    for (size_t size : {0, 1, 2, 1000, 5000, 70000, 200000})
+    {
+        for (size_t fan_in : {2, 3, 8, 64})
+        {
+            std::vector<std::pair<int, int>> xs(size);
+            for (size_t i = 0; i < size; ++i)
+            {
+                xs[i] = {generator(mt_19937), static_cast<int>(i)};
+            }
+
+            auto comp = [](auto const & a, auto const & b) { return a.first < b.first; };
+
+            size_t expected_inversions{};
+            auto expected = merge_sort(xs, comp, expected_inversions);
+
+            REQUIRE(kway_merge_sort(xs.begin(), xs.end(), comp, fan_in) == expected_inversions);
+            REQUIRE(xs == expected);
+        }
+    }
+}
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <string>
 #include <cstring>
+#include <memory>
 #include <catch2/catch_test_macros.hpp>
 #include <fmt/core.h>
 
@@ -46,6 +47,44 @@ TEST_CASE("Sort counts number of inversions")
     REQUIRE(inversions == 15);
 }
 
+TEST_CASE("Sort in place over a range")
+{
+    std::vector<std::string> words{"pear", "apple", "fig", "apple", "banana"};
+    REQUIRE(merge_sort(words.begin(), words.end()) == 6);
+    REQUIRE(words == std::vector<std::string>{"apple", "apple", "banana", "fig", "pear"});
+
+    int xs[] = {6, 5, 4, 3, 2, 1, 0};
+    REQUIRE(merge_sort(std::begin(xs), std::end(xs)) == 21);
+    REQUIRE(std::is_sorted(std::begin(xs), std::end(xs)));
+
+    std::vector<std::unique_ptr<int>> ptrs{};
+    for (int x : {3, 1, 2})
+    {
+        ptrs.push_back(std::make_unique<int>(x));
+    }
+    REQUIRE(merge_sort(ptrs.begin(), ptrs.end(), [](auto const & a, auto const & b) { return *a < *b; }) == 2);
+    REQUIRE(*ptrs[0] == 1);
+    REQUIRE(*ptrs[1] == 2);
+    REQUIRE(*ptrs[2] == 3);
+
+    struct Record
+    {
+        std::string key;
+        int payload;
+    };
+    std::vector<Record> records{{"b", 1}, {"a", 2}, {"b", 3}, {"a", 4}};
+    REQUIRE(merge_sort(records.begin(), records.end(), [](auto const & a, auto const & b) { return a.key < b.key; }) == 3);
+    REQUIRE(records[0].payload == 2);
+    REQUIRE(records[1].payload == 4);
+    REQUIRE(records[2].payload == 1);
+    REQUIRE(records[3].payload == 3);
+
+    ThreadPool pool{3};
+    std::vector<std::string> more_words{"pear", "apple", "fig", "apple", "banana"};
+    REQUIRE(merge_sort(pool, more_words.begin(), more_words.end()) == 6);
+    REQUIRE(more_words == std::vector<std::string>{"apple", "apple", "banana", "fig", "pear"});
+}
+
 size_t count_inversions_slow(std::vector<int> const & xs)
 {
     size_t res{0};
@@ -108,4 +147,95 @@ TEST_CASE("Assigment 3.5")
     REQUIRE(inversions == 2407905288);
 
     data_file.close();
-}
\ No newline at end of file
+}
+
+TEST_CASE("Parallel sort matches the sequential one")
+{
+    ThreadPool pool{4};
+
+    REQUIRE(merge_sort(pool, std::vector<int>{}).empty());
+    REQUIRE(merge_sort(pool, std::vector<int>{1}) == std::vector<int>{1});
+
+    auto fist_digit_comp = [](int a, int b) { return first_digit(a) < first_digit(b); };
+    REQUIRE(merge_sort<int>(pool, {32, 31, 21, 22, 15, 11, 1}, fist_digit_comp) == std::vector<int>{15, 11, 1, 21, 22, 32, 31});
+
+    std::random_device random_device{};
+    std::mt19937 mt_19937{random_device()};
+    std::uniform_int_distribution<int> generator{0, 1000};
+
+    for (int i = 0; i < 200; ++i)
+    {
+        std::vector<int> xs(generator(mt_19937) * 10);
+        std::generate(xs.begin(), xs.end(), [&]() { return generator(mt_19937); });
+
+        size_t expected_inversions{};
+        auto expected = merge_sort(xs, expected_inversions);
+
+        size_t inversions{};
+        REQUIRE(merge_sort(pool, xs, inversions) == expected);
+        REQUIRE(inversions == expected_inversions);
+    }
+
+    // Values without a default constructor, moved into the buffer instead
+    struct Key
+    {
+        explicit Key(int value) : value(value) {}
+        int value;
+    };
+    auto by_value = [](Key const & a, Key const & b) { return a.value < b.value; };
+
+    for (size_t size : {2, 5, 33, 100, 1001})
+    {
+        std::vector<int> xs(size);
+        std::generate(xs.begin(), xs.end(), [&]() { return generator(mt_19937); });
+        std::vector<Key> keys(xs.begin(), xs.end());
+
+        size_t expected_inversions{};
+        auto expected = merge_sort(xs, expected_inversions);
+
+        REQUIRE(merge_sort(pool, keys.begin(), keys.end(), by_value, {3, 64}) == expected_inversions);
+        REQUIRE(std::equal(keys.begin(), keys.end(), expected.begin(), expected.end(), [](Key const & k, int x) { return k.value == x; }));
+    }
+}
+
+TEST_CASE("Block base case and cache tiling keep the counts exact")
+{
+    std::random_device random_device{};
+    std::mt19937 mt_19937{random_device()};
+    std::uniform_int_distribution<int> generator{0, 50};
+
+    auto brute_force = [](auto const & xs)
+    {
+        uint64_t inversions = 0;
+        for (size_t i = 0; i < xs.size(); ++i)
+            for (size_t j = i + 1; j < xs.size(); ++j)
+            {
+                inversions += xs[j] < xs[i];
+            }
+        return inversions;
+    };
+
+    std::vector<MergeSortTuning> tunings{{}, {2, 64}, {3, 64}, {7, 1000}, {16, 1}, {64, size_t{1} << 20}};
+
+    for (auto const & tuning : tunings)
+    {
+        for (size_t size : {0, 1, 2, 5, 31, 32, 33, 100, 257, 1000, 3001})
+        {
+            std::vector<int> xs(size);
+            std::generate(xs.begin(), xs.end(), [&]() { return generator(mt_19937); });
+
+            auto expected = xs;
+            std::stable_sort(expected.begin(), expected.end());
+
+            auto ys = xs;
+            REQUIRE(merge_sort(ys.begin(), ys.end(), std::less<>{}, tuning) == brute_force(xs));
+            REQUIRE(ys == expected);
+
+            // Strings are not trivially copyable and take the ping-pong path
+            std::vector<std::string> words(size);
+            std::transform(xs.begin(), xs.end(), words.begin(), [](int x) { return fmt::format("{:03}", x); });
+            REQUIRE(merge_sort(words.begin(), words.end(), std::less<>{}, tuning) == brute_force(xs));
+            REQUIRE(std::is_sorted(words.begin(), words.end()));
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#include <random>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/bignum.hpp"
+#include "../src/mod_context.hpp"
+
+namespace
+{
+    BigNum random_bignum(std::mt19937_64 & mt_19937, size_t size)
+    {
+        std::vector<uint64_t> x(size);
+        std::generate(x.begin(), x.end(), mt_19937);
+        return BigNum{x};
+    }
+
+    BigNum remainder(BigNum const & a, BigNum const & m)
+    {
+        return divmod(a, m).second;
+    }
+
+    // Right-to-left binary exponentiation with a division after every product
+    BigNum powmod_reference(BigNum const & base, BigNum const & exponent, BigNum const & m)
+    {
+        BigNum res = remainder(BigNum{1}, m);
+        BigNum power = remainder(base, m);
+        for (auto e : exponent.limbs())
+        {
+            for (int i = 0; i < 64; ++i, e >>= 1)
+            {
+                if (e & 1)
+                {
+                    res = remainder(multiply(res, power), m);
+                }
+                power = remainder(multiply(power, power), m);
+            }
+        }
+        return res;
+    }
+}
+
+TEST_CASE("Modular arithmetic with small moduli")
+{
+    ModContext context{BigNum{97}};
+    REQUIRE(context.mulmod(BigNum{50}, BigNum{60}) == BigNum{3000 % 97});
+    REQUIRE(context.sqrmod(BigNum{1000}) == BigNum{1000000 % 97});
+    REQUIRE(context.powmod(BigNum{5}, BigNum{}) == BigNum{1});
+    REQUIRE(context.powmod(BigNum{}, BigNum{3}).is_zero());
+
+    // Fermat's little theorem
+    for (uint64_t a = 1; a < 97; ++a)
+    {
+        REQUIRE(context.powmod(BigNum{a}, BigNum{96}) == BigNum{1});
+    }
+
+    ModContext unit{BigNum{1}};
+    REQUIRE(unit.powmod(BigNum{5}, BigNum{}).is_zero());
+    REQUIRE(unit.mulmod(BigNum{5}, BigNum{7}).is_zero());
+
+    REQUIRE_THROWS_AS(ModContext{BigNum{}}, std::invalid_argument);
+    REQUIRE_THROWS_AS(ModContext{BigNum{10}}, std::invalid_argument);
+}
+
+TEST_CASE("Modular arithmetic with multi-limb moduli")
+{
+    std::mt19937_64 mt_19937{21};
+
+    for (size_t size : {1, 2, 5, 32, 40})
+    {
+        auto m = random_bignum(mt_19937, size);
+        m = add(m, BigNum{(m.limbs()[0] & 1) == 0 ? 1u : 0u});
+        ModContext context{m};
+
+        for (int i = 0; i < 3; ++i)
+        {
+            auto a = random_bignum(mt_19937, size);
+            auto b = random_bignum(mt_19937, 2 * size + 1);
+            REQUIRE(context.mulmod(a, b) == remainder(multiply(a, b), m));
+            REQUIRE(context.sqrmod(b) == remainder(multiply(b, b), m));
+        }
+
+        // Exponents from a single bit to every window width
+        for (size_t e_size : {1, 2, 12})
+        {
+            auto base = random_bignum(mt_19937, size + 1);
+            auto exponent = random_bignum(mt_19937, e_size);
+            REQUIRE(context.powmod(base, exponent) == powmod_reference(base, exponent, m));
+        }
+        REQUIRE(context.powmod(BigNum{3}, BigNum{1}) == remainder(BigNum{3}, m));
+        REQUIRE(context.powmod(subtract(m, BigNum{1}), BigNum{2}) == remainder(BigNum{1}, m));
+    }
+}
@@ -1,7 +1,14 @@
+#include <algorithm>
+#include <memory_resource>
+#include <random>
 #include <catch2/catch_test_macros.hpp>
 
+#include "../src/arena.hpp"
+#include "../src/bignum.hpp"
+#include "../src/interleaved.hpp"
 #include "../src/merge_sort.hpp"
 #include "../src/product.hpp"
+#include "random_bigint.hpp"
 
 bigint add(std::string const & a, std::string const & b)
 {
@@ -49,6 +56,70 @@ TEST_CASE("Test subtract")
     REQUIRE(subtract("99", "90") == bigint{9});
 }
 
+TEST_CASE("In-place add and subtract")
+{
+    auto acc = bigint_from_string("999");
+    add_to(acc, bigint_from_string("1"));
+    REQUIRE(acc == bigint{1, 0, 0, 0});
+    add_to(acc, acc);
+    REQUIRE(acc == bigint{2, 0, 0, 0});
+    add_to(acc, {});
+    REQUIRE(acc == bigint{2, 0, 0, 0});
+
+    sub_from(acc, bigint_from_string("1999"));
+    REQUIRE(acc == bigint{1});
+    sub_from(acc, acc);
+    REQUIRE(acc.empty());
+
+    add_shifted(acc, bigint_from_string("12"), 3);
+    REQUIRE(acc == bigint_from_string("12000"));
+    add_shifted(acc, bigint_from_string("99"), 2);
+    REQUIRE(acc == bigint_from_string("21900"));
+    add_shifted(acc, acc, 1);
+    REQUIRE(acc == bigint_from_string("240900"));
+    add_shifted(acc, bigint_from_string("1"), 0);
+    REQUIRE(acc == bigint_from_string("240901"));
+}
+
+TEST_CASE("Add and subtract reuse rvalue operands")
+{
+    // Past the inline digits, so the buffer moves with the value
+    auto lhs = bigint_from_string("123456789");
+    lhs.reserve(64);
+    auto const * buffer = lhs.data();
+
+    auto sum = add(std::move(lhs), bigint_from_string("876543211"));
+    REQUIRE(sum == bigint_from_string("1000000000"));
+    REQUIRE(sum.data() == buffer);
+
+    auto difference = subtract(bigint_from_string("1000000001"), std::move(sum));
+    REQUIRE(difference == bigint{1});
+    REQUIRE(difference.data() == buffer);
+
+    sum = add(bigint_from_string("5"), std::move(difference));
+    REQUIRE(sum == bigint{6});
+    REQUIRE(sum.data() == buffer);
+
+    REQUIRE(subtract(std::move(sum), bigint{6}).empty());
+
+    // Steady-state accumulation stays in one buffer
+    std::mt19937 mt_19937{3};
+    std::uniform_int_distribution<int> digit{0, 9};
+    bigint acc{};
+    acc.reserve(64);
+    buffer = acc.data();
+    bigint expected{};
+    for (int i = 0; i < 1000; ++i)
+    {
+        bigint x(20);
+        std::generate(x.begin(), x.end(), [&] { return static_cast<uint8_t>(digit(mt_19937)); });
+        add_to(acc, x);
+        expected = add(expected, x);
+        REQUIRE(acc == expected);
+    }
+    REQUIRE(acc.data() == buffer);
+}
+
 TEST_CASE("Test multiply")
 {
     REQUIRE(multiply("1", "1") == bigint{1});
@@ -73,3 +144,399 @@ TEST_CASE("Test assignment")
 
     REQUIRE(multiply(a, b) == expected);
 }
+
+TEST_CASE("Multiply above the schoolbook cutoff")
+{
+    std::mt19937 mt_19937{3};
+
+    for (auto [a_size, b_size] : {std::pair{300, 300}, {450, 440}, {2000, 2000}, {5000, 1000}, {3001, 997}, {1500, 9}})
+    {
+        auto a = random_bigint(mt_19937, a_size);
+        auto b = random_bigint(mt_19937, b_size);
+
+        auto expected = bigint_from_bignum(multiply(bignum_from_bigint(a), bignum_from_bigint(b)));
+        REQUIRE(multiply(a, b) == expected);
+        REQUIRE(multiply(b, a) == expected);
+    }
+
+    // Leading zeros do not reach the product
+    REQUIRE(multiply(bigint{0, 0, 7}, bigint{0, 4}) == bigint{2, 8});
+    REQUIRE(multiply(bigint{0}, bigint{5}).empty());
+
+    auto nines = bigint(1000, 9);
+    auto expected = bigint(999, 9);
+    expected.push_back(8);
+    expected.insert(expected.end(), 999, 0);
+    expected.push_back(1);
+    REQUIRE(multiply(nines, nines) == expected);
+}
+
+TEST_CASE("Multiply through the transform")
+{
+    std::mt19937 mt_19937{5};
+
+    // Long enough for the decimal transform, short enough for BigNum's Karatsuba to check it
+    for (auto [a_size, b_size] : {std::pair{20000, 20000}, {40000, 19000}, {60000, 25000}})
+    {
+        auto a = random_bigint(mt_19937, a_size);
+        auto b = random_bigint(mt_19937, b_size);
+
+        auto expected = bigint_from_bignum(multiply(bignum_from_bigint(a), bignum_from_bigint(b)));
+        REQUIRE(multiply(a, b) == expected);
+    }
+
+    auto nines = bigint(30000, 9);
+    auto expected = bigint(29999, 9);
+    expected.push_back(8);
+    expected.insert(expected.end(), 29999, 0);
+    expected.push_back(1);
+    REQUIRE(multiply(nines, nines) == expected);
+}
+
+TEST_CASE("Every multiply tier gives the same product")
+{
+    std::mt19937 mt_19937{11};
+
+    auto saved = multiply_thresholds();
+
+    std::vector<MultiplyThresholds> tiers{
+        {SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX},
+        {8, SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX},
+        {8, 30, SIZE_MAX, SIZE_MAX, SIZE_MAX},
+        {8, SIZE_MAX, 30, SIZE_MAX, SIZE_MAX},
+        {8, 30, 90, SIZE_MAX, SIZE_MAX},
+        {8, 30, 90, 200, SIZE_MAX},
+    };
+
+    for (auto [a_size, b_size] : {std::pair{2000, 2000}, {4000, 1500}, {999, 997}, {300, 280}})
+    {
+        auto a = random_bigint(mt_19937, a_size);
+        auto b = random_bigint(mt_19937, b_size);
+
+        multiply_thresholds() = tiers.front();
+        auto expected = multiply(a, b);
+
+        for (auto const & tier : tiers)
+        {
+            multiply_thresholds() = tier;
+            REQUIRE(multiply(a, b) == expected);
+        }
+    }
+
+    multiply_thresholds() = saved;
+}
+
+TEST_CASE("Multiply on a thread pool matches the serial product")
+{
+    std::mt19937 mt_19937{12};
+
+    ThreadPool pool{4};
+    auto saved = multiply_thresholds();
+    multiply_thresholds().parallel = 40;
+
+    for (auto [a_size, b_size] : {std::pair{3000, 3000}, {2999, 2990}, {9000, 1000}, {5000, 700}, {300, 200}, {25000, 25000}})
+    {
+        auto a = random_bigint(mt_19937, a_size);
+        auto b = random_bigint(mt_19937, b_size);
+        REQUIRE(multiply(pool, a, b) == multiply(a, b));
+        REQUIRE(multiply(pool, b, a) == multiply(a, b));
+    }
+
+    REQUIRE(multiply(pool, bigint{}, bigint{7}).empty());
+
+    multiply_thresholds() = saved;
+}
+
+TEST_CASE("Square matches the general multiply on every tier")
+{
+    std::mt19937 mt_19937{15};
+    std::uniform_int_distribution<int> digit{0, 9};
+
+    REQUIRE(square(bigint{}).empty());
+    REQUIRE(square(bigint{0, 0}).empty());
+    REQUIRE(square(bigint{9}) == bigint{8, 1});
+
+    auto saved = multiply_thresholds();
+
+    std::vector<MultiplyThresholds> tiers{
+        saved,
+        {SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX},
+        {8, SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX},
+        {8, 30, 90, SIZE_MAX, SIZE_MAX},
+        {8, 30, 90, 200, SIZE_MAX},
+    };
+
+    for (size_t size : {1, 9, 10, 250, 2001, 9000})
+    {
+        bigint a(size);
+        std::generate(a.begin(), a.end(), [&]() { return digit(mt_19937); });
+        a.front() = 1 + digit(mt_19937) % 9;
+        auto copy = a;
+        auto nines = bigint(size, 9);
+        auto nines_copy = nines;
+
+        for (auto const & tier : tiers)
+        {
+            multiply_thresholds() = tier;
+            auto expected = multiply(a, copy);
+            REQUIRE(square(a) == expected);
+            REQUIRE(multiply(a, a) == expected);
+            REQUIRE(square(nines) == multiply(nines, nines_copy));
+        }
+    }
+
+    ThreadPool pool{3};
+    multiply_thresholds().parallel = 40;
+    auto a = bigint(5000, 7);
+    auto copy = a;
+    REQUIRE(multiply(pool, a, a) == multiply(a, copy));
+
+    multiply_thresholds() = saved;
+}
+
+TEST_CASE("Test divmod")
+{
+    auto divmod_strings = [](std::string const & a, std::string const & b)
+    {
+        auto [q, r] = divmod(bigint_from_string(a), bigint_from_string(b));
+        return std::pair{string_from_bigint(q), string_from_bigint(r)};
+    };
+
+    REQUIRE(divmod_strings("7", "2") == std::pair<std::string, std::string>{"3", "1"});
+    REQUIRE(divmod_strings("6", "3") == std::pair<std::string, std::string>{"2", ""});
+    REQUIRE(divmod_strings("5", "17") == std::pair<std::string, std::string>{"", "5"});
+    REQUIRE(divmod_strings("100000000000000000000000000000000000001", "7")
+            == std::pair<std::string, std::string>{"14285714285714285714285714285714285714", "3"});
+    REQUIRE(divmod_strings("1000000000000000000000000", "999999999999")
+            == std::pair<std::string, std::string>{"1000000000001", "1"});
+
+    REQUIRE_THROWS_AS(divmod(bigint{1}, bigint{}), std::invalid_argument);
+    REQUIRE_THROWS_AS(divmod(bigint{1}, bigint{0, 0}), std::invalid_argument);
+}
+
+TEST_CASE("Divmod of long operands")
+{
+    std::mt19937 mt_19937{19};
+
+    // Divisors on both sides of the switch to the Newton reciprocal, whose limbs are all
+    // nines, a power of ten, or random
+    for (auto [q_size, b_size] : {std::pair{40, 30}, {600, 20}, {1000, 1500}, {5000, 4000}, {100, 9000}})
+    {
+        for (auto const & divisor : {random_bigint(mt_19937, b_size), bigint(b_size, 9), bigint_from_string("1" + std::string(b_size - 1, '0'))})
+        {
+            auto q = random_bigint(mt_19937, q_size);
+            auto r = random_bigint(mt_19937, b_size - 1);
+            auto a = add(multiply(q, divisor), r);
+
+            REQUIRE(divmod(a, divisor) == std::pair{q, r});
+            REQUIRE(divmod(multiply(q, divisor), divisor) == std::pair{q, bigint{}});
+
+            // One below a multiple of the divisor puts the remainder at its largest
+            auto [q_below, r_below] = divmod(subtract(multiply(q, divisor), bigint{1}), divisor);
+            REQUIRE(add(q_below, bigint{1}) == q);
+            REQUIRE(add(r_below, bigint{1}) == divisor);
+        }
+    }
+}
+
+namespace
+{
+    // Counts what reaches the upstream of an arena
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+        size_t allocations = 0;
+        size_t outstanding = 0;
+
+    private:
+        void * do_allocate(size_t bytes, size_t alignment) override
+        {
+            ++allocations;
+            ++outstanding;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void * p, size_t bytes, size_t alignment) override
+        {
+            --outstanding;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(std::pmr::memory_resource const & other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+}
+
+TEST_CASE("Arena reuses temporaries freed in reverse order")
+{
+    CountingResource upstream;
+    {
+        Arena arena{1024, &upstream};
+        REQUIRE(upstream.allocations == 0);
+
+        void * first = arena.allocate(100);
+        REQUIRE(upstream.allocations == 1);
+        void * second = arena.allocate(200, 64);
+        REQUIRE(reinterpret_cast<uintptr_t>(second) % 64 == 0);
+        arena.deallocate(second, 200, 64);
+        REQUIRE(arena.allocate(200, 64) == second);
+
+        // Freeing below the top keeps the memory, a request past the chunk takes a new one
+        arena.deallocate(first, 100);
+        REQUIRE(arena.allocate(16) != first);
+        REQUIRE(arena.allocate(4096) != nullptr);
+        REQUIRE(upstream.allocations == 2);
+    }
+    REQUIRE(upstream.outstanding == 0);
+
+    {
+        alignas(std::max_align_t) std::byte local[256];
+        Arena arena{local, 1024, &upstream};
+        void * first = arena.allocate(200);
+        REQUIRE(first == local);
+        arena.deallocate(first, 200);
+        REQUIRE(arena.allocate(256) == local);
+        REQUIRE(upstream.allocations == 2);
+
+        REQUIRE(arena.allocate(1) != nullptr);
+        REQUIRE(upstream.allocations == 3);
+    }
+    REQUIRE(upstream.outstanding == 0);
+
+    {
+        ArenaScope outer{64, &upstream};
+        auto * resource = temporary_resource();
+        {
+            ArenaScope inner{64, &upstream};
+            REQUIRE(temporary_resource() != resource);
+        }
+        REQUIRE(temporary_resource() == resource);
+    }
+    REQUIRE(temporary_resource() == std::pmr::get_default_resource());
+    REQUIRE(upstream.outstanding == 0);
+}
+
+TEST_CASE("Multiply and divmod make a constant number of allocations")
+{
+    std::mt19937 mt_19937{21};
+
+    // From schoolbook through Toom to the transform
+    for (auto [a_size, b_size] : {std::pair{40, 30}, {3000, 1000}, {12000, 10000}, {100000, 100000}, {200000, 30000}})
+    {
+        auto a = random_bigint(mt_19937, a_size);
+        auto b = random_bigint(mt_19937, b_size);
+
+        CountingResource upstream;
+        auto product = multiply(a, b, &upstream);
+        REQUIRE(product == multiply(a, b));
+        REQUIRE(square(b, &upstream) == multiply(b, bigint{b}));
+        REQUIRE(divmod(product, a, &upstream) == std::pair{b, bigint{}});
+        REQUIRE(divmod(add(product, bigint{1}), b, &upstream) == std::pair{a, bigint{1}});
+
+        // At most two chunks for each of the four calls
+        REQUIRE(upstream.allocations <= 4 * 2);
+        REQUIRE(upstream.outstanding == 0);
+    }
+}
+
+TEST_CASE("Short numbers are multiplied and divided without allocating")
+{
+    auto a = bigint_from_string("3141592653589793238");
+    auto b = bigint_from_string("2718281828459045235");
+    REQUIRE(a.is_inline());
+
+    CountingResource upstream;
+    auto product = multiply(a, b, &upstream);
+    REQUIRE(product == bigint_from_string("8539734222673567063074079294539120930"));
+    REQUIRE(product.is_inline());
+    REQUIRE(square(a, &upstream).is_inline());
+
+    auto [q, r] = divmod(product, bigint_from_string("1000000007"), &upstream);
+    REQUIRE(add(multiply(q, bigint_from_string("1000000007")), r) == product);
+    REQUIRE(q.is_inline());
+
+    // A few hundred digits still fit the arena on the stack
+    bigint expected{};
+    add_shifted(expected, bigint(150, 9), 150);
+    sub_from(expected, bigint(150, 9));
+    REQUIRE(multiply(bigint(150, 9), bigint(150, 9), &upstream) == expected);
+    REQUIRE(upstream.allocations == 0);
+
+    auto sum = add(a, b);
+    REQUIRE(sum.is_inline());
+    add_to(sum, product);
+    REQUIRE(sum.is_inline());
+}
+
+TEST_CASE("Batched multiply")
+{
+    std::mt19937 mt_19937{24};
+    std::uniform_int_distribution<size_t> length{0, 600};
+
+    // Random lengths, runs of equal lengths longer and shorter than the lanes, and all
+    // nines, whose column sums come closest to overflowing
+    std::vector<bigint> lhs;
+    std::vector<bigint> rhs;
+    for (int i = 0; i < 300; ++i)
+    {
+        lhs.push_back(random_bigint(mt_19937, length(mt_19937)));
+        rhs.push_back(random_bigint(mt_19937, length(mt_19937)));
+    }
+    for (size_t size : {50, 200, 207, 500})
+    {
+        for (int i = 0; i < 13; ++i)
+        {
+            lhs.push_back(random_bigint(mt_19937, size));
+            rhs.push_back(random_bigint(mt_19937, i % 2 ? size : 120));
+        }
+    }
+    lhs.push_back(bigint(207, 9));
+    rhs.push_back(bigint(207, 9));
+    lhs.push_back(bigint(1000, 9));
+    rhs.push_back(bigint(450, 9));
+    for (int i = 0; i < 3; ++i)
+    {
+        lhs.push_back(random_bigint(mt_19937, 800));
+        rhs.push_back(random_bigint(mt_19937, 700));
+    }
+    lhs.push_back({});
+    rhs.push_back(bigint{7});
+
+    std::vector<bigint> expected;
+    for (size_t i = 0; i < lhs.size(); ++i)
+    {
+        expected.push_back(multiply(lhs[i], rhs[i]));
+    }
+
+    // Every interleaved kernel this CPU runs, not only the one picked at startup
+    ThreadPool pool{4};
+    for (auto kernel : {InterleavedKernel::Scalar, InterleavedKernel::Avx2})
+    {
+        if (!interleaved_supports(kernel))
+        {
+            continue;
+        }
+
+        auto const previous = use_interleaved_kernel(kernel);
+
+        std::vector<bigint> out(lhs.size());
+        multiply_batch(lhs, rhs, out);
+        REQUIRE(out == expected);
+
+        std::vector<bigint> pooled(lhs.size());
+        multiply_batch(pool, lhs, rhs, pooled);
+        REQUIRE(pooled == expected);
+
+        use_interleaved_kernel(previous);
+    }
+    REQUIRE(interleaved_supports(InterleavedKernel::Scalar));
+
+    // The products may replace one of the operands
+    multiply_batch(lhs, rhs, lhs);
+    REQUIRE(lhs == expected);
+
+    std::vector<bigint> out(3);
+    REQUIRE_THROWS_AS(multiply_batch(rhs, rhs, out), std::invalid_argument);
+}
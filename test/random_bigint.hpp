@@ -0,0 +1,19 @@
+#pragma once
+
+#include <algorithm>
+#include <random>
+
+#include "../src/product.hpp"
+
+// Random digits below a non-zero leading one, or zero for size 0
+inline bigint random_bigint(std::mt19937 & mt_19937, size_t size)
+{
+    std::uniform_int_distribution<int> digit{0, 9};
+    bigint res(size);
+    std::generate(res.begin(), res.end(), [&]() { return digit(mt_19937); });
+    if (size > 0)
+    {
+        res.front() = 1 + digit(mt_19937) % 9;
+    }
+    return res;
+}
@@ -0,0 +1,78 @@
+#include <random>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/product.hpp"
+#include "../src/signed_bigint.hpp"
+
+namespace
+{
+    SignedBigint from(std::string const & str)
+    {
+        return signed_bigint_from_string(str);
+    }
+
+    std::string text(SignedBigint const & n)
+    {
+        return string_from_signed_bigint(n);
+    }
+}
+
+TEST_CASE("Compare bigint numerically")
+{
+    REQUIRE(compare(bigint_from_string("99"), bigint_from_string("100")) == std::strong_ordering::less);
+    REQUIRE(compare(bigint_from_string("0099"), bigint_from_string("99")) == std::strong_ordering::equal);
+    REQUIRE(compare(bigint_from_string("123"), bigint_from_string("122")) == std::strong_ordering::greater);
+    REQUIRE(compare(bigint{}, bigint{0, 0}) == std::strong_ordering::equal);
+    REQUIRE(compare(bigint{}, bigint{1}) == std::strong_ordering::less);
+}
+
+TEST_CASE("Signed bigint conversions")
+{
+    REQUIRE(text(from("-123")) == "-123");
+    REQUIRE(text(from("00123")) == "123");
+    REQUIRE(from("-0").is_zero());
+    REQUIRE(!from("-0").is_negative());
+    REQUIRE(from("-0") == SignedBigint{});
+    REQUIRE(text(negate(from("5"))) == "-5");
+    REQUIRE(!negate(SignedBigint{}).is_negative());
+
+    REQUIRE_THROWS_AS(from("--1"), std::invalid_argument);
+    REQUIRE_THROWS_AS(from("-"), std::invalid_argument);
+}
+
+TEST_CASE("Signed add and subtract")
+{
+    REQUIRE(text(difference(bigint_from_string("1"), bigint_from_string("1000"))) == "-999");
+    REQUIRE(text(difference(bigint_from_string("1000"), bigint_from_string("1"))) == "999");
+    REQUIRE(difference(bigint_from_string("12345"), bigint_from_string("12345")).is_zero());
+    REQUIRE(text(difference(bigint_from_string("12345"), bigint_from_string("12355"))) == "-10");
+    REQUIRE(text(difference(bigint_from_string("5000001"), bigint_from_string("4999999"))) == "2");
+
+    REQUIRE(text(subtract(from("3"), from("5"))) == "-2");
+    REQUIRE(text(subtract(from("-3"), from("5"))) == "-8");
+    REQUIRE(text(subtract(from("-3"), from("-5"))) == "2");
+    REQUIRE(text(add(from("-3"), from("5"))) == "2");
+    REQUIRE(text(add(from("3"), from("-5"))) == "-2");
+    REQUIRE(text(add(from("-3"), from("-5"))) == "-8");
+    REQUIRE(add(from("-7"), from("7")).is_zero());
+    REQUIRE(text(multiply(from("-12"), from("12"))) == "-144");
+    REQUIRE(text(multiply(from("-12"), from("-12"))) == "144");
+    REQUIRE(!multiply(from("-12"), SignedBigint{}).is_negative());
+}
+
+TEST_CASE("Signed arithmetic against small integers")
+{
+    std::mt19937_64 mt_19937{23};
+    std::uniform_int_distribution<int64_t> value{-1'000'000'000'000, 1'000'000'000'000};
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        int64_t a = value(mt_19937);
+        int64_t b = i % 10 == 0 ? a : value(mt_19937) >> (i % 40);
+
+        REQUIRE(text(add(from(std::to_string(a)), from(std::to_string(b)))) == std::to_string(a + b).substr(a + b == 0));
+        REQUIRE(text(subtract(from(std::to_string(a)), from(std::to_string(b)))) == std::to_string(a - b).substr(a - b == 0));
+        REQUIRE((from(std::to_string(a)) <=> from(std::to_string(b))) == (a <=> b));
+    }
+}
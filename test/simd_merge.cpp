@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/merge_sort.hpp"
+#include "../src/simd_merge.hpp"
+
+template <typename T>
+void check_simd_merge(std::mt19937 & mt_19937)
+{
+    std::uniform_int_distribution<int> sizes{0, 300};
+    std::uniform_int_distribution<int> values{-500, 500};
+
+    for (int i = 0; i < 300; ++i)
+    {
+        std::vector<T> a(sizes(mt_19937));
+        std::vector<T> b(sizes(mt_19937));
+        std::generate(a.begin(), a.end(), [&]() { return static_cast<T>(values(mt_19937)); });
+        std::generate(b.begin(), b.end(), [&]() { return static_cast<T>(values(mt_19937)); });
+        std::sort(a.begin(), a.end());
+        std::sort(b.begin(), b.end());
+
+        std::vector<T> expected(a.size() + b.size());
+        std::merge(a.cbegin(), a.cend(), b.cbegin(), b.cend(), expected.begin());
+
+        uint64_t expected_inversions{0};
+        for (auto y : b)
+        {
+            expected_inversions += a.cend() - std::upper_bound(a.cbegin(), a.cend(), y);
+        }
+
+        std::vector<T> merged(a.size() + b.size());
+        REQUIRE(simd_merge(a.data(), a.size(), b.data(), b.size(), merged.data()) == expected_inversions);
+        REQUIRE(merged == expected);
+    }
+}
+
+// Signed zeros and NaNs must come out as they went in, only the order may change
+template <typename T, typename Bits>
+void check_exact_values(std::mt19937 & mt_19937)
+{
+    std::uniform_int_distribution<int> sizes{0, 100};
+    std::uniform_int_distribution<int> values{-3, 3};
+    std::uniform_int_distribution<int> kinds{0, 9};
+
+    auto bits = [](std::vector<T> const & xs)
+    {
+        std::vector<Bits> res(xs.size());
+        std::memcpy(res.data(), xs.data(), xs.size() * sizeof(T));
+        std::sort(res.begin(), res.end());
+        return res;
+    };
+
+    for (int i = 0; i < 300; ++i)
+    {
+        auto random_values = [&]()
+        {
+            std::vector<T> xs(sizes(mt_19937));
+            std::generate(xs.begin(), xs.end(), [&]() { return static_cast<T>(values(mt_19937)); });
+            std::sort(xs.begin(), xs.end());
+            for (auto & x : xs)
+            {
+                int kind = kinds(mt_19937);
+                if (x == 0 && kind < 5)
+                {
+                    x = -x;
+                }
+                else if (kind == 9)
+                {
+                    x = std::numeric_limits<T>::quiet_NaN();
+                }
+            }
+            return xs;
+        };
+
+        auto a = random_values();
+        auto b = random_values();
+
+        std::vector<T> all(a);
+        all.insert(all.end(), b.begin(), b.end());
+
+        std::vector<T> merged(a.size() + b.size());
+        simd_merge(a.data(), a.size(), b.data(), b.size(), merged.data());
+        REQUIRE(bits(merged) == bits(all));
+    }
+}
+
+TEST_CASE("Vectorized merge of arithmetic keys")
+{
+    std::random_device random_device{};
+    std::mt19937 mt_19937{random_device()};
+
+    // Every kernel this CPU runs, not only the one picked at startup
+    for (auto kernel : {SimdMergeKernel::Scalar, SimdMergeKernel::Avx2, SimdMergeKernel::Avx512})
+    {
+        if (!simd_merge_supports(kernel))
+        {
+            continue;
+        }
+
+        auto const previous = use_simd_merge_kernel(kernel);
+        check_simd_merge<int32_t>(mt_19937);
+        check_simd_merge<uint32_t>(mt_19937);
+        check_simd_merge<int64_t>(mt_19937);
+        check_simd_merge<float>(mt_19937);
+        check_simd_merge<double>(mt_19937);
+        check_exact_values<float, uint32_t>(mt_19937);
+        check_exact_values<double, uint64_t>(mt_19937);
+        use_simd_merge_kernel(previous);
+    }
+
+    REQUIRE(simd_merge_supports(SimdMergeKernel::Scalar));
+}
+
+TEST_CASE("Sorting arithmetic keys through the vectorized merge")
+{
+    std::random_device random_device{};
+    std::mt19937 mt_19937{random_device()};
+    std::uniform_real_distribution<double> generator{-1000, 1000};
+
+    std::vector<double> xs(5000);
+    std::generate(xs.begin(), xs.end(), [&]() { return generator(mt_19937); });
+
+    size_t expected{};
+    auto scalar = merge_sort(xs, [](double a, double b) { return a < b; }, expected);
+
+    size_t inversions{};
+    REQUIRE(merge_sort(xs, inversions) == scalar);
+    REQUIRE(inversions == expected);
+}
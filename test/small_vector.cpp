@@ -0,0 +1,88 @@
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/small_vector.hpp"
+
+using Small = SmallVector<uint8_t, 8>;
+
+TEST_CASE("SmallVector stays inline up to its capacity")
+{
+    Small x{1, 2, 3};
+    REQUIRE(x.size() == 3);
+    REQUIRE(x.is_inline());
+    REQUIRE(x.capacity() == 8);
+
+    x.insert(x.begin(), 5, 0);
+    REQUIRE(x == Small{0, 0, 0, 0, 0, 1, 2, 3});
+    REQUIRE(x.is_inline());
+
+    x.push_back(4);
+    REQUIRE(!x.is_inline());
+    REQUIRE(x == Small{0, 0, 0, 0, 0, 1, 2, 3, 4});
+
+    x.erase(x.begin(), x.begin() + 5);
+    REQUIRE(x == Small{1, 2, 3, 4});
+    REQUIRE(!x.is_inline());
+
+    Small y(3, 7);
+    REQUIRE(y == Small{7, 7, 7});
+    y.resize(5);
+    REQUIRE(y == Small{7, 7, 7, 0, 0});
+    y.pop_back();
+    REQUIRE(y.back() == 0);
+    y.resize_for_overwrite(2);
+    REQUIRE(y == Small{7, 7});
+    y.resize_for_overwrite(12);
+    REQUIRE(y.size() == 12);
+    REQUIRE(!y.is_inline());
+    REQUIRE(y[1] == 7);
+    REQUIRE(Small(5).size() == 5);
+    REQUIRE(Small{1, 2} < Small{1, 3});
+    REQUIRE(Small{1, 2} < Small{1, 2, 0});
+
+    // Elements of the vector itself, taken by reference while it grows
+    Small z{9, 1, 2, 3, 4, 5, 6, 7};
+    z.push_back(z.front());
+    z.insert(z.begin(), 3, z.back());
+    REQUIRE(z == Small{9, 9, 9, 9, 1, 2, 3, 4, 5, 6, 7, 9});
+}
+
+TEST_CASE("SmallVector copies and moves")
+{
+    Small short_one{1, 2, 3};
+    Small long_one(20, 4);
+    auto const * heap = long_one.data();
+
+    Small copy = long_one;
+    REQUIRE(copy == long_one);
+    REQUIRE(copy.data() != heap);
+
+    Small moved = std::move(long_one);
+    REQUIRE(moved.data() == heap);
+    REQUIRE(long_one.empty());
+    REQUIRE(long_one.is_inline());
+
+    Small moved_short = std::move(short_one);
+    REQUIRE(moved_short == Small{1, 2, 3});
+    REQUIRE(moved_short.is_inline());
+
+    moved_short = std::move(moved);
+    REQUIRE(moved_short.data() == heap);
+    moved = moved_short;
+    moved_short = Small{5};
+    REQUIRE(moved_short == Small{5});
+    REQUIRE(moved == copy);
+
+    moved.swap(moved_short);
+    REQUIRE(moved == Small{5});
+    REQUIRE(moved_short == copy);
+
+    // Input iterators grow one value at a time
+    std::istringstream stream{"1 2 3 4 5 6 7 8 9 10"};
+    std::vector<int> values(std::istream_iterator<int>{stream}, std::istream_iterator<int>{});
+    std::istringstream again{"1 2 3 4 5 6 7 8 9 10"};
+    SmallVector<int, 4> from_stream(std::istream_iterator<int>{again}, std::istream_iterator<int>{});
+    REQUIRE(std::equal(from_stream.begin(), from_stream.end(), values.begin(), values.end()));
+}